@@ -0,0 +1,125 @@
+#include "ball_tracker.h"
+#include <algorithm>
+#include <iostream>
+#include <yaml-cpp/yaml.h>
+
+BallTracker::BallTracker(){
+    initalize_kalman();
+}
+
+void BallTracker::initalize_kalman(){
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        YAML::Node kalman = config["kalman"];
+
+        process_noise = kalman["processNoise"].as<float>();
+        measurement_noise = kalman["measurementNoise"].as<float>();
+        initial_velocity = kalman["initialVelocity"].as<float>();
+        gate = kalman["gate"].as<float>();
+        max_coast = kalman["maxCoast"].as<float>();
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading kalman config: " << e.what() << std::endl;
+        process_noise = 10000.f;
+        measurement_noise = 2.f;
+        initial_velocity = 300.f;
+        gate = 16.f;
+        max_coast = 0.5f;
+    }
+}
+
+void BallTracker::propagate(State& s, int64_t t_ns) const {
+    const float dt = (t_ns - s.stamp_ns) * 1e-9f;
+    if (dt <= 0.f) return;
+
+    const float q = process_noise;
+    for (int axis = 0; axis < 2; axis++) {
+        float* P = s.cov[axis];
+        s.pos[axis] += s.vel[axis] * dt;
+        // P = F P F' + Q for F = [1 dt; 0 1], Q from white acceleration
+        const float pp = P[0] + dt * (2.f * P[1] + dt * P[2]) + q * dt * dt * dt / 3.f;
+        const float pv = P[1] + dt * P[2] + q * dt * dt / 2.f;
+        const float vv = P[2] + q * dt;
+        P[0] = pp;
+        P[1] = pv;
+        P[2] = vv;
+    }
+    s.stamp_ns = t_ns;
+}
+
+void BallTracker::update(const BallObservation& obs, int64_t stamp_ns){
+    if (current.valid) propagate(current, stamp_ns);
+
+    const float r = measurement_noise * measurement_noise;
+    if (obs.found && current.valid) {
+        // Innovation and its Mahalanobis distance
+        float y[2] = {obs.px - current.pos[0], obs.py - current.pos[1]};
+        float nis = 0.f;
+        for (int axis = 0; axis < 2; axis++) {
+            nis += y[axis] * y[axis] / (current.cov[axis][0] + r);
+        }
+        if (nis <= gate) {
+            for (int axis = 0; axis < 2; axis++) {
+                float* P = current.cov[axis];
+                const float k0 = P[0] / (P[0] + r);
+                const float k1 = P[1] / (P[0] + r);
+                current.pos[axis] += k0 * y[axis];
+                current.vel[axis] += k1 * y[axis];
+                const float vv = P[2] - k1 * P[1];
+                P[1] = (1.f - k0) * P[1];
+                P[0] = (1.f - k0) * P[0];
+                P[2] = vv;
+            }
+            current.misses = 0;
+            current.last_hit_ns = stamp_ns;
+            current.radius = obs.radius;
+            return;
+        }
+        // Outside the gate: a coasting track lost the ball, restart on
+        // the detection; otherwise treat it as a false detection
+        if (current.misses > 0) current.valid = false;
+    }
+
+    if (obs.found && !current.valid) {
+        // Start a track at rest with a wide velocity prior
+        current = State{};
+        current.valid = true;
+        current.stamp_ns = stamp_ns;
+        current.last_hit_ns = stamp_ns;
+        current.pos[0] = obs.px;
+        current.pos[1] = obs.py;
+        const float v0 = initial_velocity * initial_velocity;
+        for (auto& P : current.cov) {
+            P[0] = r;
+            P[1] = 0.f;
+            P[2] = v0;
+        }
+        current.radius = obs.radius;
+        return;
+    }
+
+    // Nothing usable in this frame, coast on the prediction
+    if (current.valid) {
+        current.misses++;
+        if ((stamp_ns - current.last_hit_ns) * 1e-9f > max_coast) current = State{};
+    }
+}
+
+BallEstimate BallTracker::predict(const State& state, int64_t t_ns) const {
+    BallEstimate est{};
+    if (!state.valid || (t_ns - state.last_hit_ns) * 1e-9f > max_coast) return est;
+
+    State s = state;
+    propagate(s, t_ns);
+
+    est.valid = true;
+    est.coasting = s.misses > 0;
+    est.x = s.pos[0];
+    est.y = s.pos[1];
+    est.vx = s.vel[0];
+    est.vy = s.vel[1];
+    std::copy(s.cov[0], s.cov[0] + 3, est.cov_x);
+    std::copy(s.cov[1], s.cov[1] + 3, est.cov_y);
+    est.radius = s.radius;
+    est.age = std::max(0.f, (t_ns - s.last_hit_ns) * 1e-9f);
+    return est;
+}
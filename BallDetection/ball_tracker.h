@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include "detect_ball.h"
+
+// Ball state predicted by BallTracker for one point in time.
+// Position in image pixels, velocity in pixels per second; the covariance
+// is per axis (x and y are filtered independently) as
+// {position variance, position-velocity covariance, velocity variance}.
+struct BallEstimate {
+    bool  valid;
+    bool  coasting;    // no detection since the last camera frame
+    float x, y;
+    float vx, vy;
+    float cov_x[3];
+    float cov_y[3];
+    float radius;      // from the last detection, pixels
+    float age;         // seconds since the last detection
+};
+
+// Constant-velocity Kalman filter over the camera detections
+// (Vision.yaml "kalman").
+//
+// update() is fed every processed frame with its capture timestamp; a
+// frame without the ball only advances the prediction, so short
+// occlusions are bridged until `maxCoast` seconds pass without a hit.
+// Detections too far from the prediction (Mahalanobis gate) are treated
+// as misses unless the track is already coasting.
+//
+// The filter state is a small trivially copyable State, so the camera
+// thread can publish it through std::atomic and any other thread can
+// call predict() on its copy for an arbitrary steady-clock timestamp.
+class BallTracker {
+    public:
+        struct State {
+            bool    valid = false;
+            int     misses = 0;
+            int64_t stamp_ns = 0;      // time of the filter state
+            int64_t last_hit_ns = 0;   // time of the last accepted detection
+            float   pos[2] = {0.f, 0.f};
+            float   vel[2] = {0.f, 0.f};
+            float   cov[2][3] = {{0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}};
+            float   radius = 0.f;
+        };
+
+        BallTracker();
+
+        // One processed frame captured at `stamp_ns` (steady clock).
+        void update(const BallObservation& obs, int64_t stamp_ns);
+        void reset() { current = State{}; }
+
+        const State& state() const { return current; }
+
+        BallEstimate predict(int64_t t_ns) const { return predict(current, t_ns); }
+        // Does not touch the tracker, safe on a State published elsewhere.
+        BallEstimate predict(const State& state, int64_t t_ns) const;
+
+    private:
+        // Loaded from Vision.yaml "kalman"
+        float process_noise;     // white acceleration, (px/s^2)^2 per Hz
+        float measurement_noise; // detection std dev, px
+        float initial_velocity;  // initial velocity std dev, px/s
+        float gate;              // Mahalanobis distance^2 to accept a detection
+        float max_coast;         // s without a detection before the track drops
+
+        State current;
+
+        void initalize_kalman();
+        void propagate(State& s, int64_t t_ns) const;
+};
@@ -0,0 +1,117 @@
+#include "blob_extractor.h"
+#include <algorithm>
+#include <cmath>
+
+int BlobExtractor::find(int i) {
+    while (runs[i].parent != i) {
+        runs[i].parent = runs[runs[i].parent].parent;   // path halving
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+const std::vector<Blob>& BlobExtractor::extract(const uint8_t* mask, size_t step,
+                                                int width, int height, int min_area,
+                                                int ox, int oy, int scale) {
+    runs.clear();
+    found.clear();
+    scale = std::max(scale, 1);
+    const int64_t min_mask_area = std::max<int64_t>(1, (min_area + scale * scale - 1) / (scale * scale));
+
+    // ----- Runs, merged with the touching runs of the row above -----
+    size_t prev_begin = 0, prev_end = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = mask + y * step;
+        const size_t row_begin = runs.size();
+        size_t p = prev_begin;
+        int x = 0;
+        while (x < width) {
+            while (x < width && row[x] == 0) x++;
+            if (x >= width) break;
+            const int x0 = x;
+            while (x < width && row[x] != 0) x++;
+            const int id = static_cast<int>(runs.size());
+            runs.push_back(Run{y, x0, x, id});
+
+            // 8-connected: the runs above overlap [x0 - 1, x]
+            while (p < prev_end && runs[p].x1 < x0) p++;
+            for (size_t q = p; q < prev_end && runs[q].x0 <= x; q++) {
+                const int a = find(id);
+                const int b = find(static_cast<int>(q));
+                if (a != b) runs[std::max(a, b)].parent = std::min(a, b);
+            }
+        }
+        prev_begin = row_begin;
+        prev_end = runs.size();
+    }
+
+    // ----- Moments per component -----
+    root_blob.assign(runs.size(), -1);
+    sums.clear();
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run& r = runs[i];
+        const int root = find(static_cast<int>(i));
+        int& index = root_blob[root];
+        if (index < 0) {
+            index = static_cast<int>(sums.size());
+            sums.push_back(Sums{0, 0, 0, 0, 0, 0, r.x0, r.y, r.x1 - 1, r.y});
+        }
+        Sums& s = sums[index];
+
+        // Sums of x and x^2 over x0..x1-1 in closed form
+        const int64_t n = r.x1 - r.x0;
+        const int64_t a = r.x0, b = r.x1 - 1;
+        const int64_t sx = n * (a + b) / 2;
+        const int64_t sxx = (b * (b + 1) * (2 * b + 1) - (a - 1) * a * (2 * a - 1)) / 6;
+        const int64_t y = r.y;
+        s.m00 += n;
+        s.m10 += sx;
+        s.m01 += n * y;
+        s.m20 += sxx;
+        s.m11 += sx * y;
+        s.m02 += n * y * y;
+        s.x0 = std::min(s.x0, r.x0);
+        s.x1 = std::max(s.x1, r.x1 - 1);
+        s.y1 = r.y;
+    }
+
+    // ----- Blobs -----
+    for (const Sums& s : sums) {
+        if (s.m00 < min_mask_area) continue;
+        const double area = static_cast<double>(s.m00);
+        const double cx = s.m10 / area;
+        const double cy = s.m01 / area;
+        const double mu20 = s.m20 / area - cx * cx;
+        const double mu11 = s.m11 / area - cx * cy;
+        const double mu02 = s.m02 / area - cy * cy;
+
+        // Axes of the ellipse with the same second moments
+        const double common = std::sqrt(0.25 * (mu20 - mu02) * (mu20 - mu02) + mu11 * mu11);
+        const double l1 = 0.5 * (mu20 + mu02) + common;
+        const double l2 = std::max(0.5 * (mu20 + mu02) - common, 0.0);
+        const double ellipse_area = 4.0 * M_PI * std::sqrt(l1 * l2);
+        const double fill = ellipse_area > 0.0 ? area / ellipse_area : 0.0;
+        const double elongation = l1 > 0.0 ? std::sqrt(l2 / l1) : 0.0;
+
+        // Back to image pixels: a mask pixel covers scale x scale of them
+        const double k = scale;
+        Blob blob;
+        blob.area = static_cast<int>(s.m00 * scale * scale);
+        blob.x0 = s.x0 * scale + ox;
+        blob.y0 = s.y0 * scale + oy;
+        blob.x1 = s.x1 * scale + scale - 1 + ox;
+        blob.y1 = s.y1 * scale + scale - 1 + oy;
+        blob.cx = static_cast<float>(cx * k + ox);
+        blob.cy = static_cast<float>(cy * k + oy);
+        blob.mu20 = static_cast<float>(mu20 * k * k);
+        blob.mu11 = static_cast<float>(mu11 * k * k);
+        blob.mu02 = static_cast<float>(mu02 * k * k);
+        // A uniform disc of radius r has l1 = l2 = r^2 / 4
+        blob.radius = static_cast<float>(2.0 * std::sqrt(l1) * k);
+        blob.roundness = static_cast<float>(elongation * std::min(fill, fill > 0.0 ? 1.0 / fill : 0.0));
+        found.push_back(blob);
+    }
+    std::sort(found.begin(), found.end(),
+              [](const Blob& a, const Blob& b) { return a.area > b.area; });
+    return found;
+}
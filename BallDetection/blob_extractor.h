@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One 8-connected blob of a mask.  Coordinates are image pixels
+// (including the offset given to extract()).
+struct Blob {
+    int   area;                 // pixels
+    int   x0, y0, x1, y1;       // bounding box, inclusive
+    float cx, cy;               // centroid
+    float mu20, mu11, mu02;     // central second moments / area
+    float radius;               // major semi-axis of the equivalent ellipse
+    float roundness;            // 0..1, 1 = filled circle
+};
+
+// Connected components with statistics in one pass over a mask.
+//
+// Each row is cut into runs of non-zero pixels; runs touching a run of
+// the previous row are merged with union-find, and area and raw moments
+// are summed per run in closed form, so no pixel is visited twice and no
+// boundary is traced.  All buffers are members and keep their capacity,
+// so after the first few frames extract() does not allocate.
+//
+// Roundness comes from the second moments: the ratio of the equivalent
+// ellipse's axes times how well the blob fills that ellipse.
+class BlobExtractor {
+    public:
+        // Blobs of at least `min_area` pixels in a `width` x `height`
+        // 8-bit mask with rows `step` bytes apart, largest first.
+        // A decimated mask has one pixel per `scale` x `scale` image
+        // pixels (sampled at multiples of `scale`); blobs and `min_area`
+        // are in image pixels either way.  (ox, oy) is added to every
+        // coordinate, for masks of a sub-image.
+        const std::vector<Blob>& extract(const uint8_t* mask, size_t step,
+                                         int width, int height, int min_area,
+                                         int ox = 0, int oy = 0, int scale = 1);
+
+        const std::vector<Blob>& blobs() const { return found; }
+
+    private:
+        struct Run {
+            int y, x0, x1;          // x1 exclusive
+            int parent;
+        };
+        struct Sums {
+            int64_t m00, m10, m01, m20, m11, m02;
+            int x0, y0, x1, y1;
+        };
+
+        std::vector<Run> runs;
+        std::vector<int> root_blob;  // per run: index into sums, -1 if none yet
+        std::vector<Sums> sums;
+        std::vector<Blob> found;
+
+        int find(int i);
+};
@@ -0,0 +1,160 @@
+#include "camera_model.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <yaml-cpp/yaml.h>
+
+// Pinhole fallback when there is no calibration: 60 deg horizontal field
+// of view at 320x240, no distortion and no mounting (no ground estimate).
+static constexpr double DEFAULT_HFOV_RAD = 1.0472; // 60 deg
+
+CameraModel::CameraModel(){
+    initalize_calibration();
+    setImageSize(calib_w, calib_h);
+}
+
+void CameraModel::initalize_calibration(){
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        YAML::Node calib = config["calibration"];
+        YAML::Node mount = calib["mount"];
+
+        calib_w = calib["width"].as<int>();
+        calib_h = calib["height"].as<int>();
+        fx0 = calib["fx"].as<double>();
+        fy0 = calib["fy"].as<double>();
+        cx0 = calib["cx"].as<double>();
+        cy0 = calib["cy"].as<double>();
+        const auto d = calib["distortion"].as<std::vector<double>>();
+        k1 = d.size() > 0 ? d[0] : 0.0;
+        k2 = d.size() > 1 ? d[1] : 0.0;
+        p1 = d.size() > 2 ? d[2] : 0.0;
+        p2 = d.size() > 3 ? d[3] : 0.0;
+        k3 = d.size() > 4 ? d[4] : 0.0;
+
+        mount_height = mount["height"].as<float>();
+        mount_pitch = mount["pitch"].as<float>();
+        mount_yaw = mount["yaw"].as<float>();
+        mount_x = mount["x"].as<float>();
+        mount_y = mount["y"].as<float>();
+        ball_radius = calib["ballRadius"].as<float>();
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading calibration config: " << e.what() << std::endl;
+        calib_w = 320;
+        calib_h = 240;
+        fx0 = fy0 = (calib_w * 0.5) / std::tan(DEFAULT_HFOV_RAD * 0.5);
+        cx0 = calib_w * 0.5;
+        cy0 = calib_h * 0.5;
+        k1 = k2 = p1 = p2 = k3 = 0.0;
+        mount_height = 0.f;
+        mount_pitch = 0.f;
+        mount_yaw = 0.f;
+        mount_x = mount_y = 0.f;
+        ball_radius = 0.0215f;
+    }
+}
+
+void CameraModel::setImageSize(int width, int height){
+    if (width == image_w && height == image_h) return;
+    image_w = width;
+    image_h = height;
+
+    // Same field of view at another resolution
+    const double sx = static_cast<double>(width) / calib_w;
+    const double sy = static_cast<double>(height) / calib_h;
+    fx = fx0 * sx;
+    fy = fy0 * sy;
+    cx = (cx0 + 0.5) * sx - 0.5;
+    cy = (cy0 + 0.5) * sy - 0.5;
+
+    grid_w = (width + kStep - 1) / kStep + 1;
+    grid_h = (height + kStep - 1) / kStep + 1;
+    table.resize(static_cast<size_t>(grid_w) * grid_h * 2);
+    for (int gy = 0; gy < grid_h; gy++) {
+        for (int gx = 0; gx < grid_w; gx++) {
+            double xn, yn;
+            undistortExact(gx * kStep, gy * kStep, xn, yn);
+            float* t = &table[(static_cast<size_t>(gy) * grid_w + gx) * 2];
+            t[0] = static_cast<float>(xn);
+            t[1] = static_cast<float>(yn);
+        }
+    }
+}
+
+void CameraModel::undistortExact(double px, double py, double& xn, double& yn) const {
+    // Fixed-point iteration of the inverse distortion, as cv::undistortPoints
+    const double xd = (px - cx) / fx;
+    const double yd = (py - cy) / fy;
+    double x = xd, y = yd;
+    for (int i = 0; i < 20; i++) {
+        const double r2 = x * x + y * y;
+        const double radial = 1.0 + r2 * (k1 + r2 * (k2 + r2 * k3));
+        const double dx = 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+        const double dy = p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+        x = (xd - dx) / radial;
+        y = (yd - dy) / radial;
+    }
+    xn = x;
+    yn = y;
+}
+
+void CameraModel::undistort(float px, float py, float& xn, float& yn) const {
+    const float gxf = std::min(std::max(px / kStep, 0.f), grid_w - 1.001f);
+    const float gyf = std::min(std::max(py / kStep, 0.f), grid_h - 1.001f);
+    const int gx = static_cast<int>(gxf);
+    const int gy = static_cast<int>(gyf);
+    const float ax = gxf - gx;
+    const float ay = gyf - gy;
+
+    const float* t00 = &table[(static_cast<size_t>(gy) * grid_w + gx) * 2];
+    const float* t01 = t00 + 2;
+    const float* t10 = t00 + grid_w * 2;
+    const float* t11 = t10 + 2;
+    for (int k = 0; k < 2; k++) {
+        const float top = t00[k] + ax * (t01[k] - t00[k]);
+        const float bottom = t10[k] + ax * (t11[k] - t10[k]);
+        (k == 0 ? xn : yn) = top + ay * (bottom - top);
+    }
+}
+
+void CameraModel::rayToRobot(float xn, float yn, float ray[3]) const {
+    // Camera axes (x right, y down, z forward) pitched down about the
+    // robot's y axis, then yawed about z
+    const float cp = std::cos(mount_pitch), sp = std::sin(mount_pitch);
+    const float fwd = cp - yn * sp;          // along the robot x before yaw
+    const float up = -sp - yn * cp;
+    const float left = -xn;
+    const float cyaw = std::cos(mount_yaw), syaw = std::sin(mount_yaw);
+    ray[0] = cyaw * fwd - syaw * left;
+    ray[1] = syaw * fwd + cyaw * left;
+    ray[2] = up;
+}
+
+float CameraModel::bearing(float px, float py) const {
+    float xn, yn, ray[3];
+    undistort(px, py, xn, yn);
+    rayToRobot(xn, yn, ray);
+    return std::atan2(-ray[1], ray[0]);
+}
+
+bool CameraModel::groundPoint(float px, float py, float& x, float& y) const {
+    if (!hasGround()) return false;
+    float xn, yn, ray[3];
+    undistort(px, py, xn, yn);
+    rayToRobot(xn, yn, ray);
+    if (ray[2] >= -1e-6f) return false;    // at or above the horizon
+
+    const float t = (ball_radius - mount_height) / ray[2];
+    x = mount_x + t * ray[0];
+    y = mount_y + t * ray[1];
+    return true;
+}
+
+float CameraModel::rangeFromRadius(float radius_px) const {
+    if (radius_px <= 0.f) return 0.f;
+    // Angular radius to the distance of the ball centre, then onto the floor
+    const float alpha = std::atan(radius_px / static_cast<float>(0.5 * (fx + fy)));
+    const float distance = ball_radius / std::sin(alpha);
+    const float drop = mount_height - ball_radius;
+    return std::sqrt(std::max(distance * distance - drop * drop, 0.f));
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+
+// Calibrated camera (Vision.yaml "calibration").
+//
+// Intrinsics and Brown-Conrady distortion (k1, k2, p1, p2, k3, as OpenCV's
+// calibrateCamera writes them) are given for the calibration resolution
+// and scaled to the capture size.  Only detected points are undistorted:
+// a table of undistorted normalized coordinates on a coarse pixel grid is
+// built once per image size and sampled bilinearly, so no frame is ever
+// remapped.
+//
+// The mounting (height above the floor, pitch down, yaw and offset from
+// the robot centre) turns a pixel into a ray in the robot frame
+// (x forward, y left, z up, metres).
+class CameraModel {
+    public:
+        CameraModel();
+
+        // Rebuilds the undistortion table when the size changes.
+        void setImageSize(int width, int height);
+
+        // Pixel to undistorted normalized image coordinates (z = 1).
+        void undistort(float px, float py, float& xn, float& yn) const;
+
+        // Horizontal direction of the ray through a pixel, seen from the
+        // camera, relative to the robot's forward axis; radians, positive
+        // to the right.
+        float bearing(float px, float py) const;
+
+        // Ball centre on the floor in the robot frame from its centroid:
+        // the ray through the centroid is cut at ball-radius height, which
+        // is straight above the contact point.  False above the horizon or
+        // without a mounting height.
+        bool groundPoint(float px, float py, float& x, float& y) const;
+
+        // Floor distance from the camera to the ball from its apparent
+        // radius in pixels, the cross-check of groundPoint().
+        float rangeFromRadius(float radius_px) const;
+
+        bool hasGround() const { return mount_height > ball_radius; }
+
+    private:
+        // Loaded from Vision.yaml "calibration"
+        int   calib_w, calib_h;            // resolution of the intrinsics
+        double fx0, fy0, cx0, cy0;
+        double k1, k2, p1, p2, k3;
+        float mount_height;                // m, optical centre above the floor
+        float mount_pitch;                 // rad, positive looking down
+        float mount_yaw;                   // rad, positive to the left
+        float mount_x, mount_y;            // m, camera in the robot frame
+        float ball_radius;                 // m
+
+        // Intrinsics at the current image size
+        int   image_w = 0, image_h = 0;
+        double fx, fy, cx, cy;
+
+        // Undistorted (xn, yn) every kStep pixels
+        static constexpr int kStep = 4;
+        int grid_w = 0, grid_h = 0;
+        std::vector<float> table;
+
+        void initalize_calibration();
+        void undistortExact(double px, double py, double& xn, double& yn) const;
+        void rayToRobot(float xn, float yn, float ray[3]) const;
+};
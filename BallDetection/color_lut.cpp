@@ -0,0 +1,204 @@
+#include "color_lut.h"
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COLOR_LUT_NEON 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define COLOR_LUT_SSSE3 1
+#endif
+
+ColorLut::ColorLut() : table(1 << 16, 0), yuv_table(1 << 16, 0) {}
+
+uint8_t ColorLut::addClass(const std::string& name, const Range& range) {
+    if (classCount() >= kMaxClasses) return 0;
+    names.push_back(name);
+    ranges.push_back(range);
+    return static_cast<uint8_t>(1u << (classCount() - 1));
+}
+
+uint8_t ColorLut::classBit(const std::string& name) const {
+    for (int i = 0; i < classCount(); i++) {
+        if (names[i] == name) return static_cast<uint8_t>(1u << i);
+    }
+    return 0;
+}
+
+void ColorLut::bgrToHsv(uint8_t b, uint8_t g, uint8_t r,
+                        uint8_t& h, uint8_t& s, uint8_t& v) {
+    const int max = std::max({b, g, r});
+    const int min = std::min({b, g, r});
+    const int diff = max - min;
+
+    v = static_cast<uint8_t>(max);
+    s = max == 0 ? 0 : static_cast<uint8_t>((255 * diff + max / 2) / max);
+
+    if (diff == 0) {
+        h = 0;
+        return;
+    }
+    // Degrees, then halved into 0..179 as OpenCV does for 8-bit images
+    float deg;
+    if (max == r) deg = 60.f * (g - b) / diff;
+    else if (max == g) deg = 120.f + 60.f * (b - r) / diff;
+    else deg = 240.f + 60.f * (r - g) / diff;
+    if (deg < 0.f) deg += 360.f;
+    const int half = static_cast<int>(deg * 0.5f + 0.5f);
+    h = static_cast<uint8_t>(half >= 180 ? half - 180 : half);
+}
+
+void ColorLut::yuvToBgr(uint8_t y, uint8_t u, uint8_t v,
+                        uint8_t& b, uint8_t& g, uint8_t& r) {
+    const float c = 1.164f * (y - 16);
+    const float d = u - 128.f;
+    const float e = v - 128.f;
+    auto clamp = [](float x) {
+        return static_cast<uint8_t>(std::min(255.f, std::max(0.f, x + 0.5f)));
+    };
+    b = clamp(c + 2.018f * d);
+    g = clamp(c - 0.391f * d - 0.813f * e);
+    r = clamp(c + 1.596f * e);
+}
+
+uint8_t ColorLut::classify(uint8_t b, uint8_t g, uint8_t r) const {
+    uint8_t h, s, v;
+    bgrToHsv(b, g, r, h, s, v);
+
+    uint8_t bits = 0;
+    for (int c = 0; c < classCount(); c++) {
+        const Range& k = ranges[c];
+        const bool hue = k.h_lo <= k.h_hi ?
+            (h >= k.h_lo && h <= k.h_hi) :
+            (h >= k.h_lo || h <= k.h_hi);
+        if (hue && s >= k.s_lo && s <= k.s_hi && v >= k.v_lo && v <= k.v_hi) {
+            bits |= static_cast<uint8_t>(1u << c);
+        }
+    }
+    return bits;
+}
+
+void ColorLut::build() {
+    // Every bin is classified by its centre
+    for (uint32_t bi = 0; bi < 32; bi++) {
+        for (uint32_t gi = 0; gi < 64; gi++) {
+            for (uint32_t ri = 0; ri < 32; ri++) {
+                table[(bi << 11) | (gi << 5) | ri] =
+                    classify(static_cast<uint8_t>((bi << 3) | 4),
+                             static_cast<uint8_t>((gi << 2) | 2),
+                             static_cast<uint8_t>((ri << 3) | 4));
+            }
+        }
+    }
+    for (uint32_t yi = 0; yi < 64; yi++) {
+        for (uint32_t ui = 0; ui < 32; ui++) {
+            for (uint32_t vi = 0; vi < 32; vi++) {
+                uint8_t b, g, r;
+                yuvToBgr(static_cast<uint8_t>((yi << 2) | 2),
+                         static_cast<uint8_t>((ui << 3) | 4),
+                         static_cast<uint8_t>((vi << 3) | 4), b, g, r);
+                yuv_table[(yi << 10) | (ui << 5) | vi] = classify(b, g, r);
+            }
+        }
+    }
+}
+
+void ColorLut::classifyRowScalar(const uint8_t* bgr, uint8_t* out, int width, uint8_t bits) const {
+    const uint8_t* lut = table.data();
+    for (int x = 0; x < width; x++, bgr += 3) {
+        out[x] = lut[index(bgr[0], bgr[1], bgr[2])] & bits;
+    }
+}
+
+void ColorLut::classifyRow(const uint8_t* bgr, uint8_t* out, int width, uint8_t bits) const {
+    int x = 0;
+
+#if defined(COLOR_LUT_NEON) || defined(COLOR_LUT_SSSE3)
+    // The index is built from two bytes per pixel:
+    //   hi = b & 0xf8 | g >> 5,  lo = (g << 3) & 0xe0 | r >> 3
+    // sixteen pixels at a time, then looked up one by one.
+    const uint8_t* lut = table.data();
+    alignas(16) uint8_t hi[16];
+    alignas(16) uint8_t lo[16];
+#endif
+
+#if defined(COLOR_LUT_NEON)
+    const uint8x16_t mask_f8 = vdupq_n_u8(0xf8);
+    const uint8x16_t mask_e0 = vdupq_n_u8(0xe0);
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x3_t px = vld3q_u8(bgr + 3 * x);
+        vst1q_u8(hi, vorrq_u8(vandq_u8(px.val[0], mask_f8), vshrq_n_u8(px.val[1], 5)));
+        vst1q_u8(lo, vorrq_u8(vandq_u8(vshlq_n_u8(px.val[1], 3), mask_e0),
+                              vshrq_n_u8(px.val[2], 3)));
+        for (int k = 0; k < 16; k++) {
+            out[x + k] = lut[(hi[k] << 8) | lo[k]] & bits;
+        }
+    }
+#elif defined(COLOR_LUT_SSSE3)
+    // Deinterleave 16 BGR pixels (48 bytes) into B, G and R planes
+    const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    const __m128i mask_f8 = _mm_set1_epi8(static_cast<char>(0xf8));
+    const __m128i mask_e0 = _mm_set1_epi8(static_cast<char>(0xe0));
+    const __m128i mask_07 = _mm_set1_epi8(0x07);
+    const __m128i mask_1f = _mm_set1_epi8(0x1f);
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t* p = bgr + 3 * x;
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+        const __m128i blue = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(b, b1)),
+                                          _mm_shuffle_epi8(c, b2));
+        const __m128i green = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(b, g1)),
+                                           _mm_shuffle_epi8(c, g2));
+        const __m128i red = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(b, r1)),
+                                         _mm_shuffle_epi8(c, r2));
+        // No 8-bit shifts in SSE: shift 16-bit lanes and mask off the spill
+        const __m128i g_hi = _mm_and_si128(_mm_srli_epi16(green, 5), mask_07);
+        const __m128i g_lo = _mm_and_si128(_mm_slli_epi16(green, 3), mask_e0);
+        const __m128i r_lo = _mm_and_si128(_mm_srli_epi16(red, 3), mask_1f);
+        _mm_store_si128(reinterpret_cast<__m128i*>(hi), _mm_or_si128(_mm_and_si128(blue, mask_f8), g_hi));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lo), _mm_or_si128(g_lo, r_lo));
+        for (int k = 0; k < 16; k++) {
+            out[x + k] = lut[(hi[k] << 8) | lo[k]] & bits;
+        }
+    }
+#endif
+
+    classifyRowScalar(bgr + 3 * x, out + x, width - x, bits);
+}
+
+void ColorLut::classifyYuyvRow(const uint8_t* yuyv, uint8_t* out, int width, uint8_t bits) const {
+    const uint8_t* lut = yuv_table.data();
+    for (int x = 0; x < width; x += 2, yuyv += 4) {
+        const uint32_t uv = (static_cast<uint32_t>(yuyv[1] >> 3) << 5) | (yuyv[3] >> 3);
+        out[x] = lut[(static_cast<uint32_t>(yuyv[0] >> 2) << 10) | uv] & bits;
+        if (x + 1 < width) {
+            out[x + 1] = lut[(static_cast<uint32_t>(yuyv[2] >> 2) << 10) | uv] & bits;
+        }
+    }
+}
+
+void ColorLut::classifyRowStrided(const uint8_t* bgr, uint8_t* out, int width, int step, uint8_t bits) const {
+    const uint8_t* lut = table.data();
+    const size_t stride = 3 * static_cast<size_t>(step);
+    for (int x = 0; x < width; x++, bgr += stride) {
+        out[x] = lut[index(bgr[0], bgr[1], bgr[2])] & bits;
+    }
+}
+
+void ColorLut::classifyYuyvRowStrided(const uint8_t* yuyv, uint8_t* out, int width, int step, uint8_t bits) const {
+    const uint8_t* lut = yuv_table.data();
+    for (int x = 0; x < width; x++) {
+        const int px = x * step;
+        const uint8_t* pair = yuyv + 2 * (px & ~1);
+        out[x] = lut[yuvIndex(yuyv[2 * px], pair[1], pair[3])] & bits;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Colour segmentation by lookup table.
+//
+// Every BGR pixel is quantized to 5-6-5 bits (64K bins) and looked up in
+// a table holding one bit per colour class whose HSV range contains the
+// bin centre.  One pass over the image classifies every pixel into all
+// classes at once, with no HSV temporary and no per-pixel arithmetic
+// beyond the index.  build() has to run after the classes change.
+//
+// A second table of the same size is indexed by 6-5-5 bit YUV (BT.601,
+// limited range as V4L2 delivers it) so packed YUYV frames can be
+// classified without converting them to BGR first.
+//
+// HSV ranges use the OpenCV 8-bit convention (H 0..179, S and V 0..255)
+// like cv::inRange.  A range with h_lo > h_hi wraps through 0 (red).
+class ColorLut {
+    public:
+        static constexpr int kMaxClasses = 8;
+
+        struct Range {
+            uint8_t h_lo, s_lo, v_lo;
+            uint8_t h_hi, s_hi, v_hi;
+        };
+
+        ColorLut();
+
+        // Adds a class and returns its bit, 0 when all kMaxClasses are used.
+        uint8_t addClass(const std::string& name, const Range& range);
+        // Bit of a class by name, 0 if unknown.
+        uint8_t classBit(const std::string& name) const;
+        int classCount() const { return static_cast<int>(names.size()); }
+
+        void build();
+
+        uint8_t lookup(uint8_t b, uint8_t g, uint8_t r) const {
+            return table[index(b, g, r)];
+        }
+
+        // Classify `width` interleaved BGR pixels: out[x] is the class bits
+        // of pixel x masked with `bits` (0 = none of them).  Uses NEON or
+        // SSSE3 for the index computation when available.
+        void classifyRow(const uint8_t* bgr, uint8_t* out, int width, uint8_t bits) const;
+
+        // Plain scalar version of classifyRow(), kept as the reference.
+        void classifyRowScalar(const uint8_t* bgr, uint8_t* out, int width, uint8_t bits) const;
+
+        // Same for packed YUYV (Y0 U Y1 V per pixel pair).  The row has to
+        // start on a pixel pair; an odd `width` still reads the last pair.
+        void classifyYuyvRow(const uint8_t* yuyv, uint8_t* out, int width, uint8_t bits) const;
+
+        // Every `step`-th pixel of a row (pixels 0, step, 2 * step, ...),
+        // `width` outputs, for decimated masks.  BGR or packed YUYV.
+        void classifyRowStrided(const uint8_t* bgr, uint8_t* out, int width, int step, uint8_t bits) const;
+        void classifyYuyvRowStrided(const uint8_t* yuyv, uint8_t* out, int width, int step, uint8_t bits) const;
+
+        uint8_t lookupYuv(uint8_t y, uint8_t u, uint8_t v) const {
+            return yuv_table[yuvIndex(y, u, v)];
+        }
+
+        // BT.601 limited range YUV to BGR, clamped.
+        static void yuvToBgr(uint8_t y, uint8_t u, uint8_t v,
+                             uint8_t& b, uint8_t& g, uint8_t& r);
+
+        // OpenCV style 8-bit HSV of one BGR pixel.
+        static void bgrToHsv(uint8_t b, uint8_t g, uint8_t r,
+                             uint8_t& h, uint8_t& s, uint8_t& v);
+
+    private:
+        static uint32_t index(uint8_t b, uint8_t g, uint8_t r) {
+            return (static_cast<uint32_t>(b >> 3) << 11) |
+                   (static_cast<uint32_t>(g >> 2) << 5) |
+                   (r >> 3);
+        }
+
+        static uint32_t yuvIndex(uint8_t y, uint8_t u, uint8_t v) {
+            return (static_cast<uint32_t>(y >> 2) << 10) |
+                   (static_cast<uint32_t>(u >> 3) << 5) |
+                   (v >> 3);
+        }
+
+        uint8_t classify(uint8_t b, uint8_t g, uint8_t r) const;
+
+        std::vector<uint8_t> table;     // 65536 entries of class bits, BGR 5-6-5
+        std::vector<uint8_t> yuv_table; // same, YUV 6-5-5
+        std::vector<std::string> names;
+        std::vector<Range> ranges;
+};
@@ -1,77 +1,357 @@
 #include "detect_ball.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
-
-// Rough default horizontal field of view for a 320x240 USB camera.
-// Override at calibration time by editing `focal_px` after open_cam().
-static constexpr float DEFAULT_HFOV_RAD = 1.0472f; // 60 deg
+#include <yaml-cpp/yaml.h>
 
 BallDetection::BallDetection(){
 
     lower_orange = cv::Scalar(5, 100, 100);
     upper_orange = cv::Scalar(15, 255, 255);
-    frame_w = 320;
-    frame_h = 240;
-    focal_px = (frame_w * 0.5f) / std::tan(DEFAULT_HFOV_RAD * 0.5f);
+    initalize_camera();
+    camera_model.setImageSize(frame_w, frame_h);
+
+    initalize_colors();
+    initalize_tracking();
+    initalize_detection();
+}
+
+void BallDetection::initalize_camera(){
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        YAML::Node camera = config["camera"];
+
+        backend = camera["backend"].as<std::string>();
+        device = camera["device"].as<std::string>();
+        if (!V4l2Capture::parseFormat(camera["format"].as<std::string>(), v4l2_format)) {
+            std::cerr << "Vision.yaml: unknown camera format, using YUYV\n";
+            v4l2_format = V4l2Capture::Format::YUYV;
+        }
+        v4l2_buffers = camera["buffers"].as<int>();
+        frame_w = camera["width"].as<int>();
+        frame_h = camera["height"].as<int>();
+        fps = camera["fps"].as<int>();
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading camera config: " << e.what() << std::endl;
+        backend = "opencv";
+        device = "/dev/video0";
+        v4l2_format = V4l2Capture::Format::YUYV;
+        v4l2_buffers = 2;
+        frame_w = 320;
+        frame_h = 240;
+        fps = 30;
+    }
+}
+
+void BallDetection::initalize_colors(){
+    auto range = [](const cv::Scalar& lower, const cv::Scalar& upper) {
+        return ColorLut::Range{
+            cv::saturate_cast<uint8_t>(lower[0]), cv::saturate_cast<uint8_t>(lower[1]),
+            cv::saturate_cast<uint8_t>(lower[2]), cv::saturate_cast<uint8_t>(upper[0]),
+            cv::saturate_cast<uint8_t>(upper[1]), cv::saturate_cast<uint8_t>(upper[2])};
+    };
+
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        for (const auto& entry : config["colors"]) {
+            const std::string name = entry.first.as<std::string>();
+            const auto lower = entry.second["lower"].as<std::vector<int>>();
+            const auto upper = entry.second["upper"].as<std::vector<int>>();
+            if (lower.size() != 3 || upper.size() != 3) {
+                std::cerr << "Vision.yaml: color " << name << " needs [h, s, v] bounds\n";
+                continue;
+            }
+            const cv::Scalar lo(lower[0], lower[1], lower[2]);
+            const cv::Scalar hi(upper[0], upper[1], upper[2]);
+            if (name == "ball") {
+                lower_orange = lo;
+                upper_orange = hi;
+            } else if (colors.addClass(name, range(lo, hi)) == 0) {
+                std::cerr << "Vision.yaml: too many colors, ignoring " << name << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading colors config: " << e.what() << std::endl;
+    }
+
+    // The ball is always a class, from the defaults if not configured
+    if (colors.classCount() == ColorLut::kMaxClasses) {
+        std::cerr << "Vision.yaml: too many colors, no room for the ball\n";
+        ball_bit = 0;
+    } else {
+        ball_bit = colors.addClass("ball", range(lower_orange, upper_orange));
+    }
+    colors.build();
+}
+
+void BallDetection::initalize_tracking(){
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        YAML::Node roi = config["tracking"];
+
+        roi_enabled = roi["enabled"].as<bool>();
+        roi_radius_scale = roi["radiusScale"].as<float>();
+        roi_velocity_scale = roi["velocityScale"].as<float>();
+        roi_min_half = roi["minHalfSize"].as<float>();
+        roi_growth = roi["growth"].as<float>();
+        roi_max_misses = roi["maxMisses"].as<int>();
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading tracking config: " << e.what() << std::endl;
+        roi_enabled = true;
+        roi_radius_scale = 3.0f;
+        roi_velocity_scale = 2.0f;
+        roi_min_half = 24.0f;
+        roi_growth = 0.5f;
+        roi_max_misses = 3;
+    }
+}
+
+void BallDetection::initalize_detection(){
+    try {
+        YAML::Node config = YAML::LoadFile("../config/Vision.yaml");
+        YAML::Node detection = config["detection"];
+
+        min_area = detection["minArea"].as<int>();
+        pyramid_enabled = detection["pyramid"].as<bool>();
+        decimation = detection["decimation"].as<int>();
+        near_radius = detection["nearRadius"].as<float>();
+        refine_margin = detection["refineMargin"].as<int>();
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading detection config: " << e.what() << std::endl;
+        min_area = 300;
+        pyramid_enabled = false;
+        decimation = 2;
+        near_radius = 24.0f;
+        refine_margin = 8;
+    }
+    decimation = std::max(decimation, 1);
+    if (decimation == 1) pyramid_enabled = false;
+}
+
+BallDetection::~BallDetection(){
+    stopCapture();
 }
 
 int BallDetection::open_cam(){
-    capture.open(0);
-    if (!capture.isOpened()) {
-        std::cerr << "Error: Could not open camera\n";
-        return -1;
+    if (backend == "replay") {
+        return open_source(FrameSource::open(device, fps)) ? 1 : -1;
+    }
+    if (backend == "v4l2") {
+        auto v4l2 = std::make_unique<V4l2Capture>();
+        if (v4l2->open(device, frame_w, frame_h, fps, v4l2_format, v4l2_buffers)) {
+            return open_source(std::move(v4l2)) ? 1 : -1;
+        }
+        std::cerr << "V4L2 capture failed, falling back to OpenCV\n";
+    }
+
+    auto camera = std::make_unique<OpenCvSource>();
+    if (!camera->openCamera(device, frame_w, frame_h, fps)) return -1;
+    return open_source(std::move(camera)) ? 1 : -1;
+}
+
+bool BallDetection::open_source(std::unique_ptr<FrameSource> src){
+    if (!src || capturing.load()) return false;
+    source = std::move(src);
+    // The driver may pick the nearest size it supports
+    if (source->width() > 0 && source->height() > 0) {
+        frame_w = source->width();
+        frame_h = source->height();
+        camera_model.setImageSize(frame_w, frame_h);
+    }
+    return true;
+}
+
+bool BallDetection::readFrame(CameraFrame& frame){
+    return source && source->read(frame);
+}
+
+bool BallDetection::startCapture(){
+    if (!source || capturing.load()) return false;
+    capturing.store(true);
+    capture_thread = std::thread(&BallDetection::captureLoop, this);
+    return true;
+}
+
+void BallDetection::stopCapture(){
+    capturing.store(false);
+    if (capture_thread.joinable()) capture_thread.join();
+}
+
+void BallDetection::captureLoop(){
+    // Recordings are played back at their own frame rate
+    const auto replay_start = std::chrono::steady_clock::now();
+    while (capturing.load(std::memory_order_relaxed)) {
+        // Blocks until the driver has the next frame
+        CameraFrame& slot = frames.back();
+        if (!readFrame(slot)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        if (!source->live()) {
+            std::this_thread::sleep_until(replay_start + std::chrono::nanoseconds(slot.stamp_ns));
+        }
+        const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        // Replayed frames are stamped from 0, move them onto the steady clock
+        if (!source->live()) slot.stamp_ns = now_ns;
+        capture_latency_ns.store(now_ns - slot.stamp_ns, std::memory_order_relaxed);
+        captured.fetch_add(1, std::memory_order_relaxed);
+        if (frames.publish()) dropped.fetch_add(1, std::memory_order_relaxed);
     }
-    capture.set(cv::CAP_PROP_FRAME_WIDTH, frame_w);
-    capture.set(cv::CAP_PROP_FRAME_HEIGHT, frame_h);
-    capture.set(cv::CAP_PROP_FPS, 30);
-    return 1;
+}
+
+bool BallDetection::observeLatest(BallObservation& obs){
+    if (!frames.update()) return false;
+    obs = process(frames.front());
+    return true;
 }
 
 BallObservation BallDetection::observe() {
+    CameraFrame frame;
+    if (!readFrame(frame)) {
+        std::cerr << "Error: Empty frame\n";
+        return BallObservation{false, 0.f, 0.f, 0.f, 0.f, 0.f};
+    }
+    return process(frame);
+}
+
+cv::Rect BallDetection::trackingRoi(const cv::Size& size) const {
+    // Around the predicted centre: a few radii plus the distance the ball
+    // moves per frame, growing with every frame it was not found.  The
+    // last sighting was 1 + misses frames ago, as in updateTrack()
+    const float frames_since = 1.f + track.misses;
+    const float px = track.px + track.vx * frames_since;
+    const float py = track.py + track.vy * frames_since;
+    const float speed = std::hypot(track.vx, track.vy);
+    const float grow = 1.f + roi_growth * track.misses;
+    const float half = std::max(roi_min_half,
+        (track.radius * roi_radius_scale + speed * roi_velocity_scale) * grow);
+
+    const cv::Rect roi(static_cast<int>(px - half), static_cast<int>(py - half),
+                       static_cast<int>(2.f * half), static_cast<int>(2.f * half));
+    return roi & cv::Rect(0, 0, size.width, size.height);
+}
+
+void BallDetection::updateTrack(bool found, float px, float py, float radius) {
+    if (!found) {
+        // Lost after too many misses, the next frame searches everywhere
+        if (track.valid && ++track.misses > roi_max_misses) track = Track{};
+        return;
+    }
+    if (track.valid) {
+        // Per-frame motion, smoothed; missed frames count as elapsed frames
+        const float frames_since = 1.f + track.misses;
+        track.vx += 0.5f * ((px - track.px) / frames_since - track.vx);
+        track.vy += 0.5f * ((py - track.py) / frames_since - track.vy);
+    } else {
+        track.vx = track.vy = 0.f;
+    }
+    track.valid = true;
+    track.misses = 0;
+    track.px = px;
+    track.py = py;
+    track.radius = radius;
+}
+
+BallObservation BallDetection::process(const CameraFrame& frame) {
+    const auto start = std::chrono::steady_clock::now();
+    BallObservation obs = process(frame.image);
+    obs.stamp_ns = frame.stamp_ns;
+    obs.sequence = frame.sequence;
+    obs.process_us = std::chrono::duration<float, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+    return obs;
+}
+
+BallObservation BallDetection::process(const cv::Mat& frame) {
     BallObservation obs{false, 0.f, 0.f, 0.f, 0.f, 0.f};
+    camera_model.setImageSize(frame.cols, frame.rows);
 
-    cv::Mat frame, hsv, mask;
-    capture >> frame;
-    if (frame.empty()) {
-        std::cerr << "Error: Empty frame\n";
+    // Only look around the last position while the ball is tracked
+    const bool tracking = roi_enabled && track.valid;
+    cv::Rect roi(0, 0, frame.cols, frame.rows);
+    if (tracking) roi = alignRoi(frame, trackingRoi(frame.size()));
+    if (roi.empty()) {
+        updateTrack(false, 0.f, 0.f, 0.f);
         return obs;
     }
 
-    cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
-    cv::inRange(hsv, lower_orange, upper_orange, mask);
-    cv::findContours(mask, contours, cv::RETR_EXTERNAL,
-                     cv::CHAIN_APPROX_SIMPLE);
+    // Full frames are searched decimated; a tracked ball only when it is
+    // big enough that the decimated image measures it well
+    int step = 1;
+    if (pyramid_enabled && (!tracking || track.radius >= near_radius)) step = decimation;
 
-    // Pick the largest contour above the area threshold.
-    double best_area = 0.0;
-    const std::vector<cv::Point>* best = nullptr;
-    for (const auto& contour : contours) {
-        double area = cv::contourArea(contour);
-        if (area > 300 && area > best_area) {
-            best_area = area;
-            best = &contour;
-        }
+    const std::vector<Blob>& blobs = detectBlobs(frame, roi, step, blob_extractor);
+    if (blobs.empty()) {
+        updateTrack(false, 0.f, 0.f, 0.f);
+        return obs;
     }
-    if (best == nullptr) return obs;
 
-    cv::Point2f center;
-    float radius = 0.f;
-    cv::minEnclosingCircle(*best, center, radius);
+    // Largest blob above the area threshold, refined at full resolution
+    // when it is small on the decimated image
+    const Blob* best = &blobs.front();
+    if (step > 1 && best->radius < near_radius) {
+        const int margin = refine_margin + static_cast<int>(best->radius);
+        const cv::Rect region = alignRoi(frame, cv::Rect(
+            best->x0 - margin, best->y0 - margin,
+            best->x1 - best->x0 + 1 + 2 * margin, best->y1 - best->y0 + 1 + 2 * margin));
+        const std::vector<Blob>& refined = detectBlobs(frame, region, 1, refine_extractor);
+        if (!refined.empty()) best = &refined.front();
+    }
 
-    // Roundness = (observed area) / (enclosing-circle area).  1.0 = perfect circle.
-    float circle_area = static_cast<float>(M_PI) * radius * radius;
-    float roundness = (circle_area > 1.f)
-        ? static_cast<float>(best_area) / circle_area
-        : 0.f;
+    const cv::Point2f center(best->cx, best->cy);
+    const float radius = best->radius;
+    updateTrack(true, center.x, center.y, radius);
 
     obs.found      = true;
     obs.px         = center.x;
     obs.py         = center.y;
     obs.radius     = radius;
-    obs.bearing    = std::atan2(center.x - frame_w * 0.5f, focal_px);
-    obs.confidence = std::min(1.0f, roundness);
+    obs.bearing    = camera_model.bearing(center.x, center.y);
+    obs.confidence = best->roundness;
+    obs.tracked    = tracking;
+    obs.ground     = camera_model.groundPoint(center.x, center.y, obs.x, obs.y);
+    // Seen from the robot centre rather than the camera when it is placed
+    if (obs.ground) obs.bearing = std::atan2(-obs.y, obs.x);
+    obs.range_radius = camera_model.rangeFromRadius(radius);
     return obs;
 }
 
+cv::Rect BallDetection::alignRoi(const cv::Mat& frame, cv::Rect roi) const {
+    roi &= cv::Rect(0, 0, frame.cols, frame.rows);
+    // YUYV rows have to start on a pixel pair
+    if (frame.type() == CV_8UC2 && (roi.x & 1)) {
+        roi.x--;
+        roi.width++;
+    }
+    return roi;
+}
+
+const std::vector<Blob>& BallDetection::detectBlobs(const cv::Mat& frame, const cv::Rect& roi,
+                                                    int step, BlobExtractor& extractor) {
+    classify(frame(roi), mask, ball_bit, step);
+    // min_area is in capture pixels, the extractor scales it to the level
+    return extractor.extract(mask.ptr<uint8_t>(0), mask.step, mask.cols, mask.rows,
+                             min_area, roi.x, roi.y, step);
+}
+
+void BallDetection::classify(const cv::Mat& frame, cv::Mat& labels, uint8_t bits, int step) const {
+    CV_Assert(frame.type() == CV_8UC3 || frame.type() == CV_8UC2);
+    step = std::max(step, 1);
+    labels.create((frame.rows + step - 1) / step, (frame.cols + step - 1) / step, CV_8UC1);
+    for (int y = 0; y < labels.rows; y++) {
+        const uint8_t* row = frame.ptr<uint8_t>(y * step);
+        uint8_t* out = labels.ptr<uint8_t>(y);
+        if (frame.type() == CV_8UC2) {
+            if (step == 1) colors.classifyYuyvRow(row, out, frame.cols, bits);
+            else colors.classifyYuyvRowStrided(row, out, labels.cols, step, bits);
+        } else {
+            if (step == 1) colors.classifyRow(row, out, frame.cols, bits);
+            else colors.classifyRowStrided(row, out, labels.cols, step, bits);
+        }
+    }
+}
+
 bool BallDetection::find_ball() {
     return observe().found;
 }
@@ -1,7 +1,17 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <thread>
+#include "triple_buffer.h"
+#include "color_lut.h"
+#include "frame_source.h"
+#include "v4l2_capture.h"
+#include "camera_model.h"
+#include "blob_extractor.h"
 #if defined(__unix__) || defined(__APPLE__)
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -12,41 +22,151 @@
 
 // One ball observation from the onboard camera.
 // Coordinates are in image pixels; bearing is the horizontal angle from
-// the camera's optical axis in radians (positive = right of center).
-// `confidence` is a [0..1] heuristic based on contour area / roundness.
+// the robot's forward axis in radians (positive = right), from the
+// calibrated camera model.  With a calibrated mounting the ball is also
+// placed on the floor in the robot frame (x forward, y left, metres).
+// `confidence` is a [0..1] heuristic, the blob roundness from its moments.
 struct BallObservation {
     bool  found;
     float px;          // centroid x in image pixels
     float py;          // centroid y in image pixels
-    float radius;      // enclosing-circle radius in pixels
-    float bearing;     // horizontal bearing from camera axis (radians)
+    float radius;      // blob radius in pixels (major semi-axis of its moment ellipse)
+    float bearing;     // horizontal bearing from the robot's forward axis (radians)
     float confidence;  // 0..1, rough quality score
+    bool  tracked;     // found in the tracking ROI, not a full-frame search
+    bool  ground;      // x and y are valid
+    float x;           // ball on the floor, robot frame (m)
+    float y;
+    float range_radius; // floor distance from the camera by apparent size (m), 0 if unknown
+    int64_t  stamp_ns;   // capture time of the frame, steady clock (driver timestamp where available)
+    uint32_t sequence;   // frame sequence number
+    float    process_us; // time spent detecting on the frame
 };
 
 
 class BallDetection{
 
     private:
-        cv::VideoCapture capture;
+        std::unique_ptr<FrameSource> source;
+
+        // Camera settings (Vision.yaml "camera")
+        std::string backend;            // v4l2, opencv or replay
+        std::string device;             // camera, or recording to replay
+        V4l2Capture::Format v4l2_format;
+        int v4l2_buffers;
+        int fps;
         cv::Scalar lower_orange;
         cv::Scalar upper_orange;
-        std::vector<std::vector<cv::Point>> contours;
+        BlobExtractor blob_extractor;   // search level
+        BlobExtractor refine_extractor; // full resolution around a coarse hit
+
+        // Detection levels (Vision.yaml "detection")
+        int   min_area;         // smallest ball blob, pixels at capture resolution
+        bool  pyramid_enabled;  // search on a decimated image, refine at full resolution
+        int   decimation;       // pixels per coarse pixel, each way
+        float near_radius;      // px, a ball this big is measured on the decimated image
+        int   refine_margin;    // px around the coarse blob searched at full resolution
 
         int frame_w;
         int frame_h;
-        float focal_px;      // horizontal focal length in pixels
+        CameraModel camera_model;
+
+        // Newest frame from the capture thread, older ones are dropped
+        TripleBuffer<CameraFrame> frames;
+        std::thread capture_thread;
+        std::atomic<bool> capturing{false};
+        std::atomic<uint64_t> captured{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<int64_t> capture_latency_ns{0};
+
+        // Colour classes (Vision.yaml "colors"), the ball is one of them
+        ColorLut colors;
+        uint8_t ball_bit;
+
+        // Processing scratch, reused between frames
+        cv::Mat mask;
+
+        // ROI tracking (Vision.yaml "tracking"): once found, only a window
+        // around the predicted position is searched
+        struct Track {
+            bool  valid = false;
+            float px = 0.f, py = 0.f;   // last centre, pixels
+            float vx = 0.f, vy = 0.f;   // pixels per processed frame
+            float radius = 0.f;
+            int   misses = 0;           // frames not found since the last hit
+        };
+        Track track;
+        bool  roi_enabled;
+        float roi_radius_scale;   // half-size in ball radii
+        float roi_velocity_scale; // extra half-size per pixel/frame of motion
+        float roi_min_half;       // smallest half-size, pixels
+        float roi_growth;         // half-size grows by this fraction per miss
+        int   roi_max_misses;     // misses before a full-frame search
+
+        void captureLoop();
+        bool readFrame(CameraFrame& frame);
+        void initalize_camera();
+        void initalize_colors();
+        void initalize_tracking();
+        void initalize_detection();
+        cv::Rect alignRoi(const cv::Mat& frame, cv::Rect roi) const;
+        const std::vector<Blob>& detectBlobs(const cv::Mat& frame, const cv::Rect& roi,
+                                             int step, BlobExtractor& extractor);
+        cv::Rect trackingRoi(const cv::Size& size) const;
+        void updateTrack(bool found, float px, float py, float radius);
 
     public:
         BallDetection();
-        ~BallDetection()=default;
+        ~BallDetection();
 
         // Legacy boolean wrapper — preserved so existing callers still link.
         bool find_ball();
 
-        // Full observation: contour centroid, radius, bearing, confidence.
+        // Full observation: blob centroid, radius, bearing, confidence.
+        // Grabs its own frame, do not use while the capture thread runs.
         BallObservation observe();
 
+        // Detection on one BGR (CV_8UC3) or packed YUYV (CV_8UC2) frame.
+        BallObservation process(const cv::Mat& frame);
+        // Same, stamped with the frame's capture time and sequence number
+        // and the processing duration.
+        BallObservation process(const CameraFrame& frame);
+
+        // Per-pixel colour class bits of a BGR or YUYV frame, restricted to `bits`,
+        // in one pass over the image.  With `step` > 1 only every step-th
+        // pixel of every step-th row is classified (a decimated label image).
+        void classify(const cv::Mat& frame, cv::Mat& labels, uint8_t bits = 0xff, int step = 1) const;
+        // Bit of a colour class from Vision.yaml, 0 if not configured.
+        uint8_t colorBit(const std::string& name) const { return colors.classBit(name); }
+
+        // Opens the camera from Vision.yaml "camera"
         int open_cam();
+        // Reads from any source instead (video file, image directory),
+        // e.g. to replay recorded frames.  Not while capturing.
+        bool open_source(std::unique_ptr<FrameSource> src);
+
+        // Capture thread: reads frames as fast as the camera delivers and
+        // keeps only the newest one.
+        bool startCapture();
+        void stopCapture();
+
+        // Process the newest captured frame.  Returns false when no frame
+        // arrived since the last call.
+        bool observeLatest(BallObservation& obs);
+
+        uint64_t framesCaptured() const { return captured.load(std::memory_order_relaxed); }
+        uint64_t framesDropped() const { return dropped.load(std::memory_order_relaxed); }
+        // Frames the V4L2 driver skipped before we could dequeue them
+        uint64_t framesLost() const { return source ? source->framesLost() : 0; }
+        // Driver timestamp to hand-over of the newest frame, microseconds
+        double captureLatencyUs() const {
+            return capture_latency_ns.load(std::memory_order_relaxed) / 1000.0;
+        }
+
+        // Every ball-coloured blob of the last processed frame at the level
+        // it was searched on (image pixels), largest first, not only the
+        // one reported as the ball.
+        const std::vector<Blob>& candidates() const { return blob_extractor.blobs(); }
 
         int image_width()  const { return frame_w; }
         int image_height() const { return frame_h; }
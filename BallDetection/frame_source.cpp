@@ -0,0 +1,121 @@
+#include "frame_source.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+
+bool is_directory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool is_camera(const std::string& path) {
+    if (!path.empty() && std::all_of(path.begin(), path.end(),
+                                     [](unsigned char c) { return std::isdigit(c); })) {
+        return true;
+    }
+    return path.compare(0, 10, "/dev/video") == 0;
+}
+
+}
+
+std::unique_ptr<FrameSource> FrameSource::open(const std::string& path, int fps) {
+    if (is_directory(path)) {
+        auto source = std::make_unique<ImageDirSource>();
+        if (source->open(path, fps)) return source;
+        return nullptr;
+    }
+    auto source = std::make_unique<OpenCvSource>();
+    const bool ok = is_camera(path) ? source->openCamera(path, 0, 0, fps) : source->openFile(path);
+    if (ok) return source;
+    return nullptr;
+}
+
+bool OpenCvSource::openCamera(const std::string& device, int width, int height, int fps) {
+    const bool index = !device.empty() && std::all_of(device.begin(), device.end(),
+        [](unsigned char c) { return std::isdigit(c); });
+    if (index) capture.open(std::stoi(device));
+    else capture.open(device);
+    if (!capture.isOpened()) {
+        std::cerr << "Error: Could not open camera " << device << "\n";
+        return false;
+    }
+    if (width > 0) capture.set(cv::CAP_PROP_FRAME_WIDTH, width);
+    if (height > 0) capture.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    if (fps > 0) capture.set(cv::CAP_PROP_FPS, fps);
+    // Keep the driver queue short, the capture thread drops stale frames anyway
+    capture.set(cv::CAP_PROP_BUFFERSIZE, 1);
+
+    is_live = true;
+    frame_w = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    frame_h = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    sequence = 0;
+    return true;
+}
+
+bool OpenCvSource::openFile(const std::string& path) {
+    capture.open(path);
+    if (!capture.isOpened()) {
+        std::cerr << "Error: Could not open video " << path << "\n";
+        return false;
+    }
+    is_live = false;
+    frame_w = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    frame_h = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    const double fps = capture.get(cv::CAP_PROP_FPS);
+    period_ns = 1e9 / (fps > 0.0 ? fps : 30.0);
+    sequence = 0;
+    return true;
+}
+
+bool OpenCvSource::read(CameraFrame& frame) {
+    if (!capture.read(frame.image) || frame.image.empty()) return false;
+    if (is_live) {
+        // No driver timestamp through OpenCV, the frame is stamped on arrival
+        frame.stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    } else {
+        frame.stamp_ns = static_cast<int64_t>(sequence * period_ns);
+    }
+    frame.sequence = sequence++;
+    return true;
+}
+
+bool ImageDirSource::open(const std::string& directory, int fps) {
+    paths.clear();
+    for (const char* pattern : {"/*.png", "/*.jpg", "/*.jpeg", "/*.bmp"}) {
+        std::vector<cv::String> found;
+        cv::glob(directory + pattern, found, false);
+        paths.insert(paths.end(), found.begin(), found.end());
+    }
+    std::sort(paths.begin(), paths.end());
+    next = 0;
+    period_ns = 1e9 / (fps > 0 ? fps : 30);
+    if (paths.empty()) {
+        std::cerr << "Error: No images in " << directory << "\n";
+        return false;
+    }
+
+    const cv::Mat first = cv::imread(paths.front(), cv::IMREAD_COLOR);
+    frame_w = first.cols;
+    frame_h = first.rows;
+    return true;
+}
+
+bool ImageDirSource::read(CameraFrame& frame) {
+    while (next < paths.size()) {
+        const size_t index = next++;
+        frame.image = cv::imread(paths[index], cv::IMREAD_COLOR);
+        if (frame.image.empty()) {
+            std::cerr << "Skipping unreadable image " << paths[index] << "\n";
+            continue;
+        }
+        frame.sequence = static_cast<uint32_t>(index);
+        frame.stamp_ns = static_cast<int64_t>(index * period_ns);
+        return true;
+    }
+    return false;
+}
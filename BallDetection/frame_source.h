@@ -0,0 +1,77 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One frame from the camera.  `image` is BGR (CV_8UC3) or packed YUYV
+// (CV_8UC2, two pixels per Y0 U Y1 V group).  `stamp_ns` is on the
+// steady clock (CLOCK_MONOTONIC), taken by the driver when the sensor
+// finished the frame where the backend supports it.  Recorded sources
+// stamp frames at their nominal frame rate from 0.
+struct CameraFrame {
+    cv::Mat  image;
+    int64_t  stamp_ns = 0;
+    uint32_t sequence = 0;
+};
+
+// Where BallDetection gets its frames: a live camera, a video file or a
+// directory of images.  read() blocks until the next frame on live
+// sources and returns false at the end of recorded ones.
+class FrameSource {
+    public:
+        virtual ~FrameSource() = default;
+
+        virtual bool read(CameraFrame& frame) = 0;
+        virtual int width() const = 0;
+        virtual int height() const = 0;
+        // Frames a live source skipped before they could be read
+        virtual uint64_t framesLost() const { return 0; }
+        virtual bool live() const = 0;
+
+        // Opens `path` as an image directory, a camera ("0", "/dev/video0")
+        // or else a video file, through OpenCV.  nullptr on failure.
+        static std::unique_ptr<FrameSource> open(const std::string& path, int fps);
+};
+
+// cv::VideoCapture on a camera or a video file.
+class OpenCvSource : public FrameSource {
+    public:
+        // A camera by index or device path
+        bool openCamera(const std::string& device, int width, int height, int fps);
+        bool openFile(const std::string& path);
+
+        bool read(CameraFrame& frame) override;
+        int width() const override { return frame_w; }
+        int height() const override { return frame_h; }
+        bool live() const override { return is_live; }
+
+    private:
+        cv::VideoCapture capture;
+        bool is_live = true;
+        int frame_w = 0;
+        int frame_h = 0;
+        double period_ns = 0.0;     // recorded sources, from the file's fps
+        uint32_t sequence = 0;
+};
+
+// Every image in a directory, in file name order.
+class ImageDirSource : public FrameSource {
+    public:
+        bool open(const std::string& directory, int fps);
+
+        bool read(CameraFrame& frame) override;
+        int width() const override { return frame_w; }
+        int height() const override { return frame_h; }
+        bool live() const override { return false; }
+
+        const std::vector<std::string>& files() const { return paths; }
+
+    private:
+        std::vector<std::string> paths;
+        size_t next = 0;
+        int frame_w = 0;
+        int frame_h = 0;
+        double period_ns = 0.0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single producer / single consumer "latest value" buffer.
+//
+// The writer fills back(), then publish() swaps it with the shared middle
+// slot; the reader's update() swaps the middle slot into front() when it
+// holds something newer.  Neither side ever waits on the other, and a
+// value the reader never picked up is simply overwritten by the next one,
+// so the reader always sees the newest complete value.
+//
+// Slots are reused, so T may keep its allocation between frames
+// (cv::Mat::create() on a slot of the same size does not reallocate).
+template <typename T>
+class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+
+        // Writer side
+        T& back() { return slots[back_index]; }
+
+        // Returns true if the previous value was never read (dropped).
+        bool publish() {
+            const uint8_t previous =
+                middle.exchange(back_index | kDirty, std::memory_order_acq_rel);
+            back_index = previous & kIndexMask;
+            return (previous & kDirty) != 0;
+        }
+
+        // Reader side.  Returns true if front() now holds a new value.
+        bool update() {
+            if ((middle.load(std::memory_order_relaxed) & kDirty) == 0) return false;
+            const uint8_t previous =
+                middle.exchange(front_index, std::memory_order_acq_rel);
+            front_index = previous & kIndexMask;
+            return true;
+        }
+
+        T& front() { return slots[front_index]; }
+
+    private:
+        static constexpr uint8_t kIndexMask = 0x03;
+        static constexpr uint8_t kDirty = 0x04;
+
+        T slots[3];
+        uint8_t back_index = 0;
+        uint8_t front_index = 1;
+        std::atomic<uint8_t> middle{2};
+};
@@ -0,0 +1,223 @@
+#include "v4l2_capture.h"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <ctime>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+namespace {
+
+// ioctl() restarted on EINTR
+int xioctl(int fd, unsigned long request, void* arg) {
+    int r;
+    do {
+        r = ioctl(fd, request, arg);
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+int64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+}
+#endif
+
+bool V4l2Capture::parseFormat(const std::string& name, Format& format) {
+    if (name == "YUYV" || name == "yuyv") {
+        format = Format::YUYV;
+        return true;
+    }
+    if (name == "MJPEG" || name == "mjpeg" || name == "MJPG") {
+        format = Format::MJPEG;
+        return true;
+    }
+    return false;
+}
+
+V4l2Capture::~V4l2Capture() {
+    close();
+}
+
+#if defined(__linux__)
+
+bool V4l2Capture::open(const std::string& device, int width, int height, int fps,
+                       Format format, int buffer_count) {
+    close();
+
+    fd = ::open(device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "V4L2: cannot open " << device << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    v4l2_capability cap{};
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0 ||
+        !(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) ||
+        !(cap.capabilities & V4L2_CAP_STREAMING)) {
+        std::cerr << "V4L2: " << device << " is not a streaming capture device\n";
+        close();
+        return false;
+    }
+
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = format == Format::YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_MJPEG;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(fd, VIDIOC_S_FMT, &fmt) < 0) {
+        std::cerr << "V4L2: VIDIOC_S_FMT failed: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    if (fmt.fmt.pix.pixelformat != (format == Format::YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_MJPEG)) {
+        std::cerr << "V4L2: " << device << " does not support the requested pixel format\n";
+        close();
+        return false;
+    }
+    frame_w = fmt.fmt.pix.width;
+    frame_h = fmt.fmt.pix.height;
+    stride = std::max<size_t>(fmt.fmt.pix.bytesperline, static_cast<size_t>(frame_w) * 2);
+    pixel_format = format;
+
+    // Frame rate is a request, not all drivers honour it
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = fps;
+    xioctl(fd, VIDIOC_S_PARM, &parm);
+
+    v4l2_requestbuffers req{};
+    req.count = std::max(buffer_count, 2);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        std::cerr << "V4L2: cannot allocate driver buffers\n";
+        close();
+        return false;
+    }
+
+    buffers.resize(req.count);
+    for (unsigned i = 0; i < req.count; i++) {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+        void* start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if (start == MAP_FAILED) {
+            std::cerr << "V4L2: mmap failed: " << std::strerror(errno) << "\n";
+            close();
+            return false;
+        }
+        buffers[i].start = start;
+        buffers[i].length = buf.length;
+        if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        std::cerr << "V4L2: VIDIOC_STREAMON failed: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    streaming = true;
+    have_sequence = false;
+    lost = 0;
+    return true;
+}
+
+void V4l2Capture::close() {
+    if (fd < 0) return;
+    if (streaming) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd, VIDIOC_STREAMOFF, &type);
+        streaming = false;
+    }
+    for (auto& b : buffers) {
+        if (b.start) munmap(b.start, b.length);
+    }
+    buffers.clear();
+    ::close(fd);
+    fd = -1;
+}
+
+bool V4l2Capture::read(CameraFrame& frame, int timeout_ms) {
+    if (fd < 0) return false;
+
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) return false;
+
+    // Driver timestamps are only usable if they are on CLOCK_MONOTONIC
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        frame.stamp_ns = static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000000LL +
+                         static_cast<int64_t>(buf.timestamp.tv_usec) * 1000LL;
+    } else {
+        frame.stamp_ns = monotonic_ns();
+    }
+    if (have_sequence && buf.sequence > last_sequence + 1) {
+        lost += buf.sequence - last_sequence - 1;
+    }
+    have_sequence = true;
+    last_sequence = buf.sequence;
+    frame.sequence = buf.sequence;
+
+    const Buffer& b = buffers[buf.index];
+    bool ok = !(buf.flags & V4L2_BUF_FLAG_ERROR);
+    if (ok && pixel_format == Format::YUYV) {
+        // Copied out so the driver buffer goes straight back to the queue
+        frame.image.create(frame_h, frame_w, CV_8UC2);
+        const size_t row = static_cast<size_t>(frame_w) * 2;
+        ok = buf.bytesused >= stride * (frame_h - 1) + row;
+        if (ok) {
+            const unsigned char* src = static_cast<const unsigned char*>(b.start);
+            for (int y = 0; y < frame_h; y++) {
+                std::memcpy(frame.image.ptr<unsigned char>(y), src + y * stride, row);
+            }
+        }
+    } else if (ok) {
+        const cv::Mat jpeg(1, static_cast<int>(buf.bytesused), CV_8UC1, b.start);
+        frame.image = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+        ok = !frame.image.empty();
+    }
+
+    xioctl(fd, VIDIOC_QBUF, &buf);
+    return ok;
+}
+
+#else
+
+bool V4l2Capture::open(const std::string& device, int, int, int, Format, int) {
+    std::cerr << "V4L2: not available on this platform (" << device << ")\n";
+    return false;
+}
+
+void V4l2Capture::close() {}
+
+bool V4l2Capture::read(CameraFrame&, int) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#include "frame_source.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Camera capture straight through V4L2 with mmap'd driver buffers.
+//
+// Unlike cv::VideoCapture the queue depth is ours (2 buffers keeps at most
+// one frame waiting), frames carry the driver's timestamp and sequence
+// number, and YUYV is handed over as is so the colour LUT can segment it
+// without a BGR conversion.  MJPEG is decoded to BGR.
+//
+// Linux only; open() fails elsewhere.
+class V4l2Capture : public FrameSource {
+    public:
+        enum class Format { YUYV, MJPEG };
+
+        V4l2Capture() = default;
+        ~V4l2Capture();
+        V4l2Capture(const V4l2Capture&) = delete;
+        V4l2Capture& operator=(const V4l2Capture&) = delete;
+
+        // The driver may adjust width and height, see width()/height().
+        bool open(const std::string& device, int width, int height, int fps,
+                  Format format, int buffers);
+        void close();
+        bool isOpened() const { return fd >= 0; }
+
+        // Waits up to `timeout_ms` for the next frame and copies it into
+        // `frame` (reusing its allocation).  The driver buffer is queued
+        // again before returning.
+        bool read(CameraFrame& frame, int timeout_ms);
+        bool read(CameraFrame& frame) override { return read(frame, 100); }
+
+        int width() const override { return frame_w; }
+        int height() const override { return frame_h; }
+        bool live() const override { return true; }
+        Format format() const { return pixel_format; }
+
+        // Frames the driver skipped, from gaps in the sequence numbers
+        uint64_t framesLost() const override { return lost.load(std::memory_order_relaxed); }
+
+        static bool parseFormat(const std::string& name, Format& format);
+
+    private:
+        struct Buffer {
+            void*  start = nullptr;
+            size_t length = 0;
+        };
+
+        int fd = -1;
+        int frame_w = 0;
+        int frame_h = 0;
+        size_t stride = 0;      // bytes per line in the driver buffer
+        Format pixel_format = Format::YUYV;
+        std::vector<Buffer> buffers;
+        bool streaming = false;
+        bool have_sequence = false;
+        uint32_t last_sequence = 0;
+        std::atomic<uint64_t> lost{0};
+};
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <yaml-cpp/yaml.h>
+#include "body_velocity.h"
+
+namespace
+{
+double clamp(double value, double limit)
+{
+    return std::max(-limit, std::min(limit, value));
+}
+}
+
+BodyVelocityController::BodyVelocityController()
+{
+    initalize_body();
+}
+
+void BodyVelocityController::initalize_body()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Control.yaml");
+        YAML::Node body = config["bodyVelocity"];
+        const char *axes[3] = {"x", "y", "w"};
+
+        is_enabled = body["enabled"].as<bool>();
+        gyro_cutoff_hz = body["gyroCutoffHz"].as<double>();
+        odom_cutoff_hz = body["odomCutoffHz"].as<double>();
+        for (int i = 0; i < 3; i++)
+        {
+            YAML::Node axis = body[axes[i]];
+            kp[i] = axis["kp"].as<double>();
+            ki[i] = axis["ki"].as<double>();
+            max_integral[i] = axis["maxIntegral"].as<double>();
+            max_correction[i] = axis["maxCorrection"].as<double>();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading body velocity config: " << e.what() << std::endl;
+        is_enabled = false;
+        gyro_cutoff_hz = 0.5;
+        odom_cutoff_hz = 10.0;
+        for (int i = 0; i < 3; i++)
+        {
+            kp[i] = 0.2;
+            ki[i] = 1.0;
+            max_integral[i] = 0.2;
+            max_correction[i] = 0.3;
+        }
+    }
+
+    gyro_cutoff_hz = std::max(gyro_cutoff_hz, 1e-3);
+}
+
+void BodyVelocityController::reset()
+{
+    est = Twist{};
+    gyro_bias = 0.0;
+    for (double &i : integral) i = 0.0;
+    has_estimate = false;
+}
+
+BodyVelocityController::Twist BodyVelocityController::update(
+    const Twist &command, const Twist &odometry,
+    double gyro_rate, bool gyro_valid,
+    double dt, const Twist &limit)
+{
+    if (!is_enabled || dt <= 0.0)
+    {
+        return command;
+    }
+
+    // --- Estimate ---
+    const double alpha = dt / (dt + 1.0 / (2.0 * M_PI * odom_cutoff_hz));
+    const double beta = dt / (dt + 1.0 / (2.0 * M_PI * gyro_cutoff_hz));
+    if (!has_estimate)
+    {
+        est = odometry;
+        if (gyro_valid) gyro_bias = gyro_rate - odometry.w;
+        has_estimate = true;
+    }
+    else
+    {
+        est.x += alpha * (odometry.x - est.x);
+        est.y += alpha * (odometry.y - est.y);
+        if (gyro_valid)
+        {
+            // Gyro above the crossover, odometry below it: the slow part
+            // of their difference is gyro bias (or sustained slip)
+            gyro_bias += beta * ((gyro_rate - odometry.w) - gyro_bias);
+            est.w = gyro_rate - gyro_bias;
+        }
+        else
+        {
+            est.w += alpha * (odometry.w - est.w);
+        }
+    }
+
+    // --- PI per axis ---
+    const double ref[3] = {command.x, command.y, command.w};
+    const double meas[3] = {est.x, est.y, est.w};
+    const double lim[3] = {limit.x, limit.y, limit.w};
+    double out[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const double error = ref[i] - meas[i];
+        integral[i] = clamp(integral[i] + ki[i] * error * dt, max_integral[i]);
+        const double correction = clamp(kp[i] * error + integral[i], max_correction[i]);
+        out[i] = clamp(ref[i] + correction, lim[i]);
+    }
+
+    Twist result;
+    result.x = out[0];
+    result.y = out[1];
+    result.w = out[2];
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef BODY_VELOCITY_H
+#define BODY_VELOCITY_H
+
+// Closed-loop body-frame velocity controller.
+//
+// The body twist is estimated from the measured wheel speeds through
+// Wheel_math::forward() and low-pass filtered.  When the pi3hat gyro is
+// available the rotation rate comes from a complementary filter: above
+// gyroCutoffHz it follows the gyro, which does not see wheel slip, and
+// below it odometry, which does not drift.  This is done by tracking the
+// gyro bias as the low-passed gyro minus odometry difference and
+// subtracting it from the gyro.  A PI loop per axis then adds
+// a bounded correction to the commanded twist so wheel slip, battery sag
+// and mechanical asymmetry are trimmed out.
+//
+// Plain arithmetic on fixed members: no allocation and the same inputs
+// always give the same outputs.
+class BodyVelocityController
+{
+public:
+    struct Twist
+    {
+        double x = 0.0;  // m/s
+        double y = 0.0;  // m/s
+        double w = 0.0;  // rad/s
+    };
+
+    BodyVelocityController();
+    ~BodyVelocityController() = default;
+
+    // `odometry` is the forward-kinematics twist, `gyro_rate` the IMU
+    // yaw rate (ignored when `gyro_valid` is false).  Returns the twist
+    // to hand to Wheel_math::calculate(), clamped to `limit`.
+    Twist update(const Twist &command, const Twist &odometry,
+                 double gyro_rate, bool gyro_valid,
+                 double dt, const Twist &limit);
+
+    void reset();
+
+    bool enabled() const { return is_enabled; }
+    void setEnabled(bool enabled) { is_enabled = enabled; }
+    const Twist &estimate() const { return est; }
+
+private:
+    bool is_enabled;
+    double gyro_cutoff_hz;   // complementary filter crossover, gyro above
+    double odom_cutoff_hz;   // low-pass on translation odometry
+    double kp[3];            // per axis x, y, w
+    double ki[3];
+    double max_integral[3];
+    double max_correction[3];
+
+    Twist est;
+    double gyro_bias = 0.0;  // rad/s, slow part of gyro minus odometry
+    double integral[3] = {};
+    bool has_estimate = false;
+
+    void initalize_body();
+};
+
+#endif // BODY_VELOCITY_H
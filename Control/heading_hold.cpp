@@ -0,0 +1,97 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <yaml-cpp/yaml.h>
+#include "heading_hold.h"
+
+namespace
+{
+double wrapAngle(double angle)
+{
+    return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+double clamp(double value, double limit)
+{
+    return std::max(-limit, std::min(limit, value));
+}
+}
+
+HeadingHold::HeadingHold()
+{
+    initalize_heading();
+}
+
+void HeadingHold::initalize_heading()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Control.yaml");
+        YAML::Node heading = config["headingHold"];
+
+        is_enabled = heading["enabled"].as<bool>();
+        hold_threshold = heading["holdThreshold"].as<double>();
+        capture_rate = heading["captureRate"].as<double>();
+        kp_heading = heading["kpHeading"].as<double>();
+        kp_rate = heading["kpRate"].as<double>();
+        ki_rate = heading["kiRate"].as<double>();
+        max_integral = heading["maxIntegral"].as<double>();
+        max_correction = heading["maxCorrection"].as<double>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading heading hold config: " << e.what() << std::endl;
+        is_enabled = false;
+        hold_threshold = 0.05;
+        capture_rate = 0.1;
+        kp_heading = 2.0;
+        kp_rate = 0.3;
+        ki_rate = 1.0;
+        max_integral = 0.3;
+        max_correction = 0.5;
+    }
+}
+
+void HeadingHold::reset()
+{
+    is_holding = false;
+    integral = 0.0;
+}
+
+double HeadingHold::update(double commanded_w, double yaw, double yaw_rate,
+                           double dt, double limit)
+{
+    if (!is_enabled || dt <= 0.0)
+    {
+        return commanded_w;
+    }
+
+    double rate_ref = commanded_w;
+
+    if (std::abs(commanded_w) < hold_threshold)
+    {
+        // Capture the heading only once the robot has stopped turning,
+        // otherwise it would be pulled back to where the turn ended.
+        if (!is_holding && std::abs(yaw_rate) < capture_rate)
+        {
+            is_holding = true;
+            target_yaw = yaw;
+        }
+        if (is_holding)
+        {
+            rate_ref = kp_heading * wrapAngle(target_yaw - yaw);
+        }
+    }
+    else
+    {
+        is_holding = false;
+    }
+
+    // PI on yaw rate, output is a correction on top of the reference.
+    const double error = rate_ref - yaw_rate;
+    integral = clamp(integral + ki_rate * error * dt, max_integral);
+    const double correction = clamp((rate_ref - commanded_w) + kp_rate * error + integral,
+                                    max_correction);
+
+    return clamp(commanded_w + correction, limit);
+}
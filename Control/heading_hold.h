@@ -0,0 +1,46 @@
+#ifndef HEADING_HOLD_H
+#define HEADING_HOLD_H
+
+// Closed-loop yaw controller using the pi3hat IMU.
+//
+// While the incoming command asks for (almost) no rotation the current
+// heading is captured once the robot has stopped turning and held with
+// a P loop on heading error.  Otherwise the commanded rotation rate is
+// tracked.  Both cases then go through a PI loop on measured yaw rate,
+// so the output is the commanded velocity_w plus a bounded correction.
+class HeadingHold
+{
+public:
+    HeadingHold();
+    ~HeadingHold() = default;
+
+    // Returns the corrected velocity_w (rad/s) for this motor cycle.
+    // `limit` is the largest |velocity_w| Wheel_math will accept.
+    double update(double commanded_w, double yaw, double yaw_rate,
+                  double dt, double limit);
+
+    // Drop the held heading and integrator, e.g. after a stop.
+    void reset();
+
+    bool enabled() const { return is_enabled; }
+    bool holding() const { return is_holding; }
+    double target() const { return target_yaw; }
+
+private:
+    bool is_enabled;
+    double hold_threshold;   // rad/s, |command| below this holds heading
+    double capture_rate;     // rad/s, heading is captured below this rate
+    double kp_heading;       // (rad/s) per rad of heading error
+    double kp_rate;          // PI gains on yaw-rate error
+    double ki_rate;
+    double max_integral;     // rad/s, integrator clamp
+    double max_correction;   // rad/s, largest change to velocity_w
+
+    bool is_holding = false;
+    double target_yaw = 0.0;
+    double integral = 0.0;
+
+    void initalize_heading();
+};
+
+#endif // HEADING_HOLD_H
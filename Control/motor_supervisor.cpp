@@ -0,0 +1,248 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <yaml-cpp/yaml.h>
+#include "moteus_protocol.h"
+#include "motor_supervisor.h"
+
+namespace
+{
+// Both need a stop to clear
+constexpr int kModeFault = static_cast<int>(mjbots::moteus::Mode::kFault);
+constexpr int kModePositionTimeout = static_cast<int>(mjbots::moteus::Mode::kPositionTimeout);
+}
+
+MotorSupervisor::MotorSupervisor()
+{
+    initalize_supervisor();
+}
+
+void MotorSupervisor::initalize_supervisor()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Safety.yaml");
+        YAML::Node supervisor = config["supervisor"];
+
+        current_limit = config["currentLimit"].as<double>();
+        faulty_grace_ms = config["faultyGrace"].as<double>();
+        overcurrent_samples = supervisor["overcurrentSamples"].as<int>();
+        warn_current = supervisor["warnCurrent"].as<double>();
+        warn_temperature = supervisor["warnTemperature"].as<double>();
+        derate_temperature = supervisor["derateTemperature"].as<double>();
+        fault_temperature = supervisor["faultTemperature"].as<double>();
+        hysteresis = supervisor["hysteresis"].as<double>();
+        derate_scale = supervisor["derateScale"].as<double>();
+        recover_time_ms = supervisor["recoverTime"].as<double>();
+        max_rearms = supervisor["maxRearms"].as<int>();
+        max_faulted = supervisor["maxFaulted"].as<int>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading supervisor config: " << e.what() << std::endl;
+        current_limit = 5.0;
+        faulty_grace_ms = 1500.0;
+        overcurrent_samples = 1;
+        warn_current = 4.0;
+        warn_temperature = 60.0;
+        derate_temperature = 70.0;
+        fault_temperature = 80.0;
+        hysteresis = 5.0;
+        derate_scale = 0.5;
+        recover_time_ms = 1000.0;
+        max_rearms = 3;
+        max_faulted = 1;
+    }
+
+    overcurrent_samples = std::max(overcurrent_samples, 1);
+    derate_scale = std::max(0.0, std::min(derate_scale, 1.0));
+    hysteresis = std::max(hysteresis, 0.0);
+
+    reset();
+}
+
+void MotorSupervisor::reset()
+{
+    for (auto &m : motors)
+    {
+        m = Motor{};
+    }
+}
+
+MotorSupervisor::State MotorSupervisor::update(int motor_id, int mode, int fault, double current,
+                                               double temperature, double dt)
+{
+    if (motor_id < 1 || motor_id > kMaxMotors) return State::OK;
+    Motor &m = motors[motor_id - 1];
+    const double elapsed_ms = std::max(dt, 0.0) * 1000.0;
+
+    const double cur = std::abs(current);
+    m.over_samples = cur > current_limit ? m.over_samples + 1 : 0;
+
+    // Fault conditions, most specific first
+    const char *fault_reason = nullptr;
+    if (mode == kModeFault)
+        fault_reason = "moteus fault";
+    else if (mode == kModePositionTimeout)
+        fault_reason = "position timeout";
+    else if (m.over_samples >= overcurrent_samples)
+        fault_reason = "overcurrent";
+    else if (temperature >= fault_temperature)
+        fault_reason = "overtemperature";
+
+    if (m.latched) return m.state;
+
+    switch (m.state)
+    {
+    case State::FAULTED:
+        // The grace period runs from the last sample still in fault
+        if (fault_reason || temperature > fault_temperature - hysteresis)
+        {
+            m.timer_ms = 0.0;
+        }
+        else
+        {
+            m.timer_ms += elapsed_ms;
+            if (m.timer_ms >= faulty_grace_ms)
+            {
+                m.state = State::RECOVERING;
+                m.timer_ms = 0.0;
+                m.reason = "re-armed";
+            }
+        }
+        break;
+    case State::RECOVERING:
+        if (fault_reason)
+        {
+            enterFault(m, fault_reason, fault);
+        }
+        else
+        {
+            m.timer_ms += elapsed_ms;
+            if (m.timer_ms >= recover_time_ms)
+            {
+                m.state = level(m, cur, temperature);
+                m.reason = "recovered";
+            }
+        }
+        break;
+    default:
+        if (fault_reason)
+        {
+            enterFault(m, fault_reason, fault);
+        }
+        else if (!std::isnan(current) && !std::isnan(temperature))
+        {
+            const State next = level(m, cur, temperature);
+            if (next != m.state)
+            {
+                m.reason = next == State::DERATED ? "temperature" :
+                           next == State::WARNING ?
+                               (cur >= warn_current ? "current" : "temperature") :
+                           "normal";
+                m.state = next;
+            }
+        }
+        break;
+    }
+
+    return m.state;
+}
+
+MotorSupervisor::State MotorSupervisor::level(const Motor &m, double current, double temperature) const
+{
+    // Leaving a level needs the reading `hysteresis` below its threshold
+    const double derate_at = m.state == State::DERATED ?
+        derate_temperature - hysteresis : derate_temperature;
+    const double warn_at = m.state == State::WARNING || m.state == State::DERATED ?
+        warn_temperature - hysteresis : warn_temperature;
+
+    if (temperature >= derate_at) return State::DERATED;
+    if (current >= warn_current || temperature >= warn_at) return State::WARNING;
+    return State::OK;
+}
+
+void MotorSupervisor::enterFault(Motor &m, const char *reason, int fault)
+{
+    m.state = State::FAULTED;
+    m.fault = fault;
+    m.timer_ms = 0.0;
+    m.over_samples = 0;
+    m.reason = reason;
+    m.rearms++;
+    if (m.rearms > max_rearms) m.latched = true;
+}
+
+MotorSupervisor::State MotorSupervisor::state(int motor_id) const
+{
+    if (motor_id < 1 || motor_id > kMaxMotors) return State::OK;
+    return motors[motor_id - 1].state;
+}
+
+double MotorSupervisor::scale(int motor_id) const
+{
+    switch (state(motor_id))
+    {
+    case State::FAULTED: return 0.0;
+    case State::DERATED:
+    case State::RECOVERING: return derate_scale;
+    default: return 1.0;
+    }
+}
+
+double MotorSupervisor::driveScale() const
+{
+    double result = 1.0;
+    for (int id = 1; id <= kMaxMotors; id++)
+    {
+        if (stopped(id)) continue;
+        result = std::min(result, scale(id));
+    }
+    return result;
+}
+
+bool MotorSupervisor::stopped(int motor_id) const
+{
+    return state(motor_id) == State::FAULTED;
+}
+
+bool MotorSupervisor::latched(int motor_id) const
+{
+    if (motor_id < 1 || motor_id > kMaxMotors) return false;
+    return motors[motor_id - 1].latched;
+}
+
+bool MotorSupervisor::escalate() const
+{
+    int faulted = 0;
+    for (const auto &m : motors)
+    {
+        if (m.state == State::FAULTED) faulted++;
+    }
+    return faulted > max_faulted;
+}
+
+const char *MotorSupervisor::reason(int motor_id) const
+{
+    if (motor_id < 1 || motor_id > kMaxMotors) return "";
+    return motors[motor_id - 1].reason;
+}
+
+int MotorSupervisor::faultCode(int motor_id) const
+{
+    if (motor_id < 1 || motor_id > kMaxMotors) return 0;
+    return motors[motor_id - 1].fault;
+}
+
+const char *MotorSupervisor::stateToString(State state)
+{
+    switch (state)
+    {
+    case State::OK: return "OK";
+    case State::WARNING: return "WARNING";
+    case State::DERATED: return "DERATED";
+    case State::FAULTED: return "FAULTED";
+    case State::RECOVERING: return "RECOVERING";
+    default: return "UNKNOWN";
+    }
+}
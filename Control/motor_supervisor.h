@@ -0,0 +1,110 @@
+#ifndef MOTOR_SUPERVISOR_H
+#define MOTOR_SUPERVISOR_H
+
+#include <array>
+#include <cstdint>
+
+// Per-motor fault supervisor.
+//
+// Each reply (moteus mode, fault code, q-axis current and temperature)
+// moves the motor through
+//
+//   OK         - within limits
+//   WARNING    - current or temperature close to the limit, full command
+//   DERATED    - temperature high, command scaled by `derateScale`
+//   FAULTED    - overcurrent, overtemperature or moteus fault; the motor
+//                is held stopped for `faultyGrace` ms
+//   RECOVERING - re-armed at `derateScale` for `recoverTime` ms, then OK
+//
+// so one motor can drop out and come back while the others keep
+// driving.  A motor that faults more than `maxRearms` times stays
+// FAULTED, and escalate() asks for the full emergency stop once more
+// than `maxFaulted` motors are out at the same time.
+//
+// Motors are indexed by motor ID (1..kMaxMotors) to match motorMap.
+class MotorSupervisor
+{
+public:
+    enum class State : uint8_t
+    {
+        OK = 0,
+        WARNING,
+        DERATED,
+        FAULTED,
+        RECOVERING,
+        NUM_STATES
+    };
+
+    static constexpr int kMaxMotors = 8;
+
+    MotorSupervisor();
+    ~MotorSupervisor() = default;
+
+    // Push one reply for `motor_id` and return its updated state.
+    // Current in Amps, temperature in C, `dt` seconds since the last
+    // motor cycle.  NaN readings are not judged.
+    State update(int motor_id, int mode, int fault, double current,
+                 double temperature, double dt);
+
+    State state(int motor_id) const;
+
+    // Command multiplier for the motor, 0 while FAULTED
+    double scale(int motor_id) const;
+
+    // Multiplier for the whole drive: the lowest scale of the motors
+    // still driving, so the body twist keeps its direction.
+    double driveScale() const;
+
+    // The motor must be sent stop instead of its command
+    bool stopped(int motor_id) const;
+
+    // FAULTED for good after too many re-arms
+    bool latched(int motor_id) const;
+
+    // Too many motors are out to keep driving safely
+    bool escalate() const;
+
+    // Why the motor last changed state
+    const char *reason(int motor_id) const;
+
+    // moteus fault code reported when the motor last faulted
+    int faultCode(int motor_id) const;
+
+    void reset();
+
+    static const char *stateToString(State state);
+
+private:
+    struct Motor
+    {
+        State state = State::OK;
+        double timer_ms = 0.0;  // time in FAULTED or RECOVERING
+        int rearms = 0;         // faults so far
+        int over_samples = 0;   // consecutive samples over currentLimit
+        bool latched = false;
+        int fault = 0;          // moteus fault code when the motor faulted
+        const char *reason = "";
+    };
+
+    // Loaded from Safety.yaml (currentLimit, faultyGrace, "supervisor")
+    double current_limit;      // A, fault threshold
+    int overcurrent_samples;   // samples over currentLimit to fault
+    double warn_current;       // A
+    double warn_temperature;   // C
+    double derate_temperature; // C
+    double fault_temperature;  // C
+    double hysteresis;         // C, below a threshold by this to clear it
+    double derate_scale;
+    double faulty_grace_ms;    // held stopped before re-arm
+    double recover_time_ms;    // derated after re-arm
+    int max_rearms;
+    int max_faulted;
+
+    std::array<Motor, kMaxMotors> motors;
+
+    void initalize_supervisor();
+    State level(const Motor &m, double current, double temperature) const;
+    void enterFault(Motor &m, const char *reason, int fault);
+};
+
+#endif // MOTOR_SUPERVISOR_H
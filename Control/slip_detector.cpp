@@ -0,0 +1,161 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <yaml-cpp/yaml.h>
+#include "slip_detector.h"
+
+SlipDetector::SlipDetector()
+{
+    initalize_detector();
+}
+
+void SlipDetector::initalize_detector()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Safety.yaml");
+        YAML::Node traction = config["traction"];
+
+        window = traction["window"].as<int>();
+        votes = traction["votes"].as<int>();
+        min_command = traction["minCommand"].as<double>();
+        slip_error = traction["slipError"].as<double>();
+        stall_ratio = traction["stallRatio"].as<double>();
+        stall_current = traction["stallCurrent"].as<double>();
+        free_spin_current = traction["freeSpinCurrent"].as<double>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading traction config: " << e.what() << std::endl;
+        window = 8;
+        votes = 5;
+        min_command = 0.5;
+        slip_error = 1.5;
+        stall_ratio = 0.2;
+        stall_current = 3.0;
+        free_spin_current = 0.3;
+    }
+
+    window = std::max(1, std::min(window, kMaxWindow));
+    votes = std::max(1, std::min(votes, window));
+
+    reset();
+}
+
+void SlipDetector::reset()
+{
+    for (auto &w : wheels)
+    {
+        w = Wheel{};
+    }
+}
+
+SlipDetector::State SlipDetector::classify(double commanded, double measured, double current) const
+{
+    const double cmd = std::abs(commanded);
+    const double cur = std::abs(current);
+
+    // Unknown readings and near-zero commands say nothing about traction.
+    if (cmd < min_command || std::isnan(measured) || std::isnan(current))
+    {
+        return State::GRIP;
+    }
+
+    const double error = std::abs(measured - commanded);
+
+    // Stall: barely moving (or moving the wrong way) while pulling current.
+    const double along = measured * (commanded > 0.0 ? 1.0 : -1.0);
+    if (along < stall_ratio * cmd && cur >= stall_current)
+    {
+        return State::STALL;
+    }
+
+    // Slip: not tracking and the motor isn't working hard to get there,
+    // i.e. the wheel has nothing to push against.
+    if (error >= slip_error && cur < stall_current)
+    {
+        return State::SLIP;
+    }
+
+    // Free spin: tracking fine but with no load at all.
+    if (error < slip_error && cur < free_spin_current)
+    {
+        return State::FREE_SPIN;
+    }
+
+    return State::GRIP;
+}
+
+SlipDetector::State SlipDetector::update(int motor_id, double commanded, double measured, double current)
+{
+    if (motor_id < 1 || motor_id > kMaxWheels)
+    {
+        return State::GRIP;
+    }
+    Wheel &w = wheels[motor_id - 1];
+
+    const State sample = classify(commanded, measured, current);
+
+    // Drop the oldest sample once the window is full.
+    if (w.filled == window)
+    {
+        w.counts[static_cast<int>(w.window[w.head])]--;
+    }
+    else
+    {
+        w.filled++;
+    }
+    w.window[w.head] = sample;
+    w.counts[static_cast<int>(sample)]++;
+    w.head = (w.head + 1) % window;
+
+    // The fault classes take priority over FREE_SPIN when both have votes.
+    if (w.counts[static_cast<int>(State::STALL)] >= votes)
+        w.state = State::STALL;
+    else if (w.counts[static_cast<int>(State::SLIP)] >= votes)
+        w.state = State::SLIP;
+    else if (w.counts[static_cast<int>(State::FREE_SPIN)] >= votes)
+        w.state = State::FREE_SPIN;
+    else
+        w.state = State::GRIP;
+
+    return w.state;
+}
+
+SlipDetector::State SlipDetector::state(int motor_id) const
+{
+    if (motor_id < 1 || motor_id > kMaxWheels)
+    {
+        return State::GRIP;
+    }
+    return wheels[motor_id - 1].state;
+}
+
+bool SlipDetector::anyLostTraction() const
+{
+    for (const auto &w : wheels)
+    {
+        if (w.state == State::SLIP || w.state == State::STALL)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *SlipDetector::stateToString(State state)
+{
+    switch (state)
+    {
+    case State::GRIP:
+        return "GRIP";
+    case State::SLIP:
+        return "SLIP";
+    case State::STALL:
+        return "STALL";
+    case State::FREE_SPIN:
+        return "FREE_SPIN";
+    default:
+        return "----";
+    }
+}
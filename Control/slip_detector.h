@@ -0,0 +1,73 @@
+#ifndef SLIP_DETECTOR_H
+#define SLIP_DETECTOR_H
+
+#include <array>
+#include <cstdint>
+
+// Per-wheel slip / stall detector.
+//
+// Every motor cycle each wheel is given the velocity it was commanded,
+// the velocity moteus measured and the q-axis current.  The sample is
+// classified on its own and pushed into a fixed sliding window; the
+// wheel's state is the class that holds a majority (`votes`) of that
+// window, otherwise GRIP.  Everything lives in fixed arrays so update()
+// never allocates and can run inside the motor cycle.
+//
+// Wheels are indexed by motor ID (1..kMaxWheels) to match motorMap.
+class SlipDetector
+{
+public:
+    enum class State : uint8_t
+    {
+        GRIP = 0,      // wheel tracks its command under normal load
+        SLIP,          // wheel cannot hold its command and is not loaded
+        STALL,         // wheel is commanded but barely turns at high current
+        FREE_SPIN,     // wheel tracks its command with almost no load (lifted)
+        NUM_STATES
+    };
+
+    static constexpr int kMaxWheels = 4;
+    static constexpr int kMaxWindow = 32;
+
+    SlipDetector();
+    ~SlipDetector() = default;
+
+    // Push one sample for the wheel driven by `motor_id` and return its
+    // updated state.  Velocities in rev/s, current in Amps.
+    State update(int motor_id, double commanded, double measured, double current);
+
+    State state(int motor_id) const;
+
+    // True when any wheel is currently classified SLIP or STALL.
+    bool anyLostTraction() const;
+
+    void reset();
+
+    static const char *stateToString(State state);
+
+private:
+    struct Wheel
+    {
+        std::array<State, kMaxWindow> window{};
+        std::array<uint8_t, static_cast<int>(State::NUM_STATES)> counts{};
+        int head = 0;
+        int filled = 0;
+        State state = State::GRIP;
+    };
+
+    // Thresholds, loaded from the "traction" block of Safety.yaml
+    int window;              // samples in the sliding window
+    int votes;               // samples that must agree to change state
+    double min_command;      // rev/s, below this a wheel is not classified
+    double slip_error;       // rev/s tracking error treated as slip
+    double stall_ratio;      // measured/commanded below this may be a stall
+    double stall_current;    // Amps, current needed to call a stall
+    double free_spin_current; // Amps, below this while tracking = unloaded
+
+    std::array<Wheel, kMaxWheels> wheels;
+
+    void initalize_detector();
+    State classify(double commanded, double measured, double current) const;
+};
+
+#endif // SLIP_DETECTOR_H
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <yaml-cpp/yaml.h>
+#include "traction_control.h"
+
+TractionController::TractionController()
+{
+    initalize_traction();
+}
+
+void TractionController::initalize_traction()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Safety.yaml");
+        YAML::Node traction = config["traction"];
+
+        accel_limit = traction["accelLimit"].as<double>();
+        backoff = traction["backoff"].as<double>();
+        recovery = traction["recovery"].as<double>();
+        min_scale = traction["minScale"].as<double>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading traction config: " << e.what() << std::endl;
+        accel_limit = 20.0;
+        backoff = 0.5;
+        recovery = 1.05;
+        min_scale = 0.1;
+    }
+
+    reset();
+}
+
+void TractionController::reset()
+{
+    accel_scale = 1.0;
+    last_output.fill(0.0);
+}
+
+void TractionController::resetWheel(int motor_id)
+{
+    if (motor_id >= 1 && motor_id <= SlipDetector::kMaxWheels)
+        last_output[motor_id - 1] = 0.0;
+}
+
+void TractionController::apply(const std::map<int, double> &target,
+                               std::map<int, double> &output,
+                               const SlipDetector &detector,
+                               double dt)
+{
+    // Update the shared acceleration scale from the latest classification.
+    if (detector.anyLostTraction())
+    {
+        accel_scale = std::max(min_scale, accel_scale * backoff);
+    }
+    else
+    {
+        accel_scale = std::min(1.0, accel_scale * recovery);
+    }
+
+    const double scaled_step = accel_limit * accel_scale * dt;
+
+    for (auto &pair : output)
+    {
+        const int motor_id = pair.first;
+        auto it = target.find(motor_id);
+        const double goal = (it != target.end()) ? it->second : 0.0;
+
+        if (motor_id < 1 || motor_id > SlipDetector::kMaxWheels)
+        {
+            // Not a wheel we track, pass straight through.
+            pair.second = goal;
+            continue;
+        }
+
+        double &last = last_output[motor_id - 1];
+        const double delta = goal - last;
+
+        // Slowing down towards zero is passed through untouched.
+        const bool braking = std::abs(goal) <= std::abs(last) && goal * last >= 0.0;
+        if (braking)
+        {
+            last = goal;
+        }
+        else
+        {
+            last += std::max(-scaled_step, std::min(scaled_step, delta));
+        }
+        pair.second = last;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef TRACTION_CONTROL_H
+#define TRACTION_CONTROL_H
+
+#include <array>
+#include <map>
+
+#include "slip_detector.h"
+
+// Acceleration limiter driven by SlipDetector.
+//
+// Wheel commands are rate limited towards their targets.  While any
+// wheel has lost traction the allowed acceleration of the whole wheel
+// set is multiplied down by `backoff` each cycle (never below
+// `minScale`); once every wheel grips again it recovers by `recovery`
+// per cycle.  All wheels share one scale so the body twist keeps its
+// direction while it is slowed down.  Slowing a wheel towards zero is
+// never limited so stop commands are not delayed by the controller.
+class TractionController
+{
+public:
+    TractionController();
+    ~TractionController() = default;
+
+    // Rate-limit `target` into `output` for a cycle of `dt` seconds.
+    // Only keys already present in `output` are written, so a map
+    // populated once up front is never reallocated.
+    void apply(const std::map<int, double> &target,
+               std::map<int, double> &output,
+               const SlipDetector &detector,
+               double dt);
+
+    double scale() const { return accel_scale; }
+
+    void reset();
+    // Forget the last output of one wheel, so it ramps up from zero
+    // the next time it is commanded
+    void resetWheel(int motor_id);
+
+private:
+    double accel_limit;  // rev/s^2 per wheel at full grip
+    double backoff;      // multiplier applied each cycle traction is lost
+    double recovery;     // multiplier applied each cycle all wheels grip
+    double min_scale;    // lower bound of the acceleration scale
+
+    double accel_scale = 1.0;
+    std::array<double, SlipDetector::kMaxWheels> last_output{};
+
+    void initalize_traction();
+};
+
+#endif // TRACTION_CONTROL_H
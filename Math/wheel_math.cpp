@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <yaml-cpp/yaml.h>
@@ -6,6 +7,112 @@
 
 Wheel_math::Wheel_math() {
     initalize_math();
+    initalize_kinematics();
+}
+
+void Wheel_math::initalize_kinematics() {
+    // Inverse kinematics rows as used by calculate(), which swaps the
+    // axes: wheel = (vy_in * sin + vx_in * cos + w * dist) / radius
+    const double rad[4] = {W1_RAD, W2_RAD, W3_RAD, W4_RAD};
+    const double dist[4] = {wheel_dist_1, wheel_dist_2, wheel_dist_3, wheel_dist_4};
+    double J[4][3];
+    for (int i = 0; i < 4; i++) {
+        J[i][0] = std::cos(rad[i]) / WHEEL_RADIUS;
+        J[i][1] = std::sin(rad[i]) / WHEEL_RADIUS;
+        J[i][2] = dist[i] / WHEEL_RADIUS;
+
+        ik_x[i] = static_cast<float>(J[i][0]);
+        ik_y[i] = static_cast<float>(J[i][1]);
+        ik_w[i] = static_cast<float>(J[i][2]);
+    }
+
+    // fk = (J^T J)^-1 J^T, the least-squares inverse of J
+    double A[3][3] = {};
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+            for (int i = 0; i < 4; i++)
+                A[r][c] += J[i][r] * J[i][c];
+
+    const double det =
+        A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) -
+        A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) +
+        A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (std::abs(det) < 1e-12) {
+        std::cerr << "error: wheel geometry is singular, forward kinematics disabled\n";
+        return;
+    }
+
+    double inv[3][3];
+    inv[0][0] =  (A[1][1] * A[2][2] - A[1][2] * A[2][1]) / det;
+    inv[0][1] = -(A[0][1] * A[2][2] - A[0][2] * A[2][1]) / det;
+    inv[0][2] =  (A[0][1] * A[1][2] - A[0][2] * A[1][1]) / det;
+    inv[1][0] = -(A[1][0] * A[2][2] - A[1][2] * A[2][0]) / det;
+    inv[1][1] =  (A[0][0] * A[2][2] - A[0][2] * A[2][0]) / det;
+    inv[1][2] = -(A[0][0] * A[1][2] - A[0][2] * A[1][0]) / det;
+    inv[2][0] =  (A[1][0] * A[2][1] - A[1][1] * A[2][0]) / det;
+    inv[2][1] = -(A[0][0] * A[2][1] - A[0][1] * A[2][0]) / det;
+    inv[2][2] =  (A[0][0] * A[1][1] - A[0][1] * A[1][0]) / det;
+
+    for (int r = 0; r < 3; r++)
+        for (int i = 0; i < 4; i++) {
+            fk[r][i] = 0.0;
+            for (int c = 0; c < 3; c++)
+                fk[r][i] += inv[r][c] * J[i][c];
+        }
+}
+
+void Wheel_math::forward(const double wheel[4], double &velocity_x, double &velocity_y,
+                         double &velocity_w) const {
+    velocity_x = fk[0][0] * wheel[0] + fk[0][1] * wheel[1] + fk[0][2] * wheel[2] + fk[0][3] * wheel[3];
+    velocity_y = fk[1][0] * wheel[0] + fk[1][1] * wheel[1] + fk[1][2] * wheel[2] + fk[1][3] * wheel[3];
+    velocity_w = fk[2][0] * wheel[0] + fk[2][1] * wheel[1] + fk[2][2] * wheel[2] + fk[2][3] * wheel[3];
+}
+
+void Wheel_math::solve_without(const double wheel[4], int stopped, double out[4]) const {
+    for (int i = 0; i < 4; i++) out[i] = wheel[i];
+    if (stopped < 0 || stopped > 3) return;
+    out[stopped] = 0.0;
+
+    // Twist the four wheels would give, then the three remaining wheel
+    // speeds that give it through forward() with the stopped one at zero
+    double twist[3];
+    forward(wheel, twist[0], twist[1], twist[2]);
+
+    int cols[3];
+    for (int i = 0, k = 0; i < 4; i++)
+        if (i != stopped) cols[k++] = i;
+    double A[3][3];
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+            A[r][c] = fk[r][cols[c]];
+
+    const double det =
+        A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) -
+        A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) +
+        A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (std::abs(det) < 1e-12) return;
+
+    // Cramer's rule, column c replaced by the twist
+    double peak = 0.0;
+    for (int c = 0; c < 3; c++) {
+        double M[3][3];
+        for (int r = 0; r < 3; r++)
+            for (int k = 0; k < 3; k++)
+                M[r][k] = (k == c) ? twist[r] : A[r][k];
+        const double det_c =
+            M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1]) -
+            M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0]) +
+            M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0]);
+        out[cols[c]] = det_c / det;
+        peak = std::max(peak, std::abs(out[cols[c]]));
+    }
+
+    // Three wheels may need more speed than four: scale the whole set
+    // back within wheelLimit so the twist keeps its direction
+    if (peak > WHEEL_LIMIT) {
+        const double scale = WHEEL_LIMIT / peak;
+        for (int c = 0; c < 3; c++) out[cols[c]] *= scale;
+    }
 }
 
 void Wheel_math::initalize_math() {
@@ -16,11 +123,13 @@ void Wheel_math::initalize_math() {
     X_LIMIT = vLimits["xLimit"].as<double>();   // m/s
     Y_LIMIT = vLimits["yLimit"].as<double>();   // m/s
     W_LIMIT = vLimits["wLimit"].as<double>();   // rad/s
+    WHEEL_LIMIT = vLimits["wheelLimit"].as<double>(80.0); // calculate() output units
     }catch (const std::exception& e) {
     std::cerr << "Error loading Velocity Limit config: " << e.what() << std::endl;
     X_LIMIT = 0.5;
     Y_LIMIT = 0.5;
     W_LIMIT = 0.1;
+    WHEEL_LIMIT = 80.0;
     }
 
 }
@@ -2,6 +2,8 @@
 #define WHEEL_MATH_H
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 class Wheel_math {
@@ -22,6 +24,7 @@ private:
     double X_LIMIT;   // m/s
     double Y_LIMIT;   // m/s
     double W_LIMIT;   // rad/s
+    double WHEEL_LIMIT; // largest wheel speed in calculate() output units
 
     // Stop state
     std::vector<double> stop_vel = {0.0, 0.0, 0.0, 0.0};
@@ -47,13 +50,56 @@ private:
     // Running mode for safety
     int mode = 0;
 
+    // Forward kinematics: least-squares body twist from the four wheel
+    // speeds, rows are (velocity_x, velocity_y, velocity_w)
+    double fk[3][4] = {};
+
+    // Inverse kinematics as single-precision coefficients for the batched
+    // path: wheel[i] = ik_x[i] * velocity_x + ik_y[i] * velocity_y + ik_w[i] * velocity_w
+    float ik_x[4] = {};
+    float ik_y[4] = {};
+    float ik_w[4] = {};
+
     void initalize_math();
+    void initalize_kinematics();
 
 public:
     Wheel_math();
     ~Wheel_math() = default;
     void setMode(int base_mode);
 
+    // Largest |velocity_x|, |velocity_y| (m/s) and |velocity_w| (rad/s)
+    // accepted by calculate()
+    double getXLimit() const { return X_LIMIT; }
+    double getYLimit() const { return Y_LIMIT; }
+    double getWLimit() const { return W_LIMIT; }
+
+    // Inverse of calculate(): body velocity from measured wheel velocities
+    // (same units as calculate() outputs).  No limits are applied.
+    void forward(const double wheel[4], double &velocity_x, double &velocity_y,
+                 double &velocity_w) const;
+
+    // Wheel speeds giving the same body twist as `wheel` (through
+    // forward()) with wheel index `stopped` (0..3) held at zero, for
+    // driving on three wheels while one motor is out.  The result is
+    // scaled down as a whole when a wheel would exceed wheelLimit.
+    void solve_without(const double wheel[4], int stopped, double out[4]) const;
+
+    // Batched evaluation for scoring candidate twists.  Inputs are
+    // structure-of-arrays of length n; wheel[0..3] receive the wheel
+    // speeds and feasible[k] is 1 when candidate k is within the x/y/w
+    // limits and no wheel exceeds wheelLimit.  Unlike calculate() no
+    // mode handling is applied, candidates are only evaluated.
+    // Uses NEON, AVX or SSE2 when available, scalar otherwise.
+    void calculate_batch(const float *velocity_x, const float *velocity_y,
+                         const float *velocity_w, size_t n,
+                         float *const wheel[4], uint8_t *feasible) const;
+
+    // Plain scalar version of calculate_batch(), kept as the reference.
+    void calculate_batch_scalar(const float *velocity_x, const float *velocity_y,
+                                const float *velocity_w, size_t n,
+                                float *const wheel[4], uint8_t *feasible) const;
+
     // Calculate wheel velocities from robot desired motion
     std::vector<double> calculate(double velocity_x, double velocity_y, double velocity_w);
 };
@@ -0,0 +1,139 @@
+#include <cmath>
+#include "wheel_math.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define WHEEL_MATH_NEON 1
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define WHEEL_MATH_AVX 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define WHEEL_MATH_SSE 1
+#endif
+
+void Wheel_math::calculate_batch_scalar(const float *velocity_x, const float *velocity_y,
+                                        const float *velocity_w, size_t n,
+                                        float *const wheel[4], uint8_t *feasible) const {
+    const float x_lim = static_cast<float>(X_LIMIT);
+    const float y_lim = static_cast<float>(Y_LIMIT);
+    const float w_lim = static_cast<float>(W_LIMIT);
+    const float wheel_lim = static_cast<float>(WHEEL_LIMIT);
+
+    for (size_t k = 0; k < n; k++) {
+        const float vx = velocity_x[k];
+        const float vy = velocity_y[k];
+        const float vw = velocity_w[k];
+        bool ok = std::abs(vx) <= x_lim && std::abs(vy) <= y_lim && std::abs(vw) <= w_lim;
+        for (int i = 0; i < 4; i++) {
+            const float v = ik_x[i] * vx + ik_y[i] * vy + ik_w[i] * vw;
+            wheel[i][k] = v;
+            ok = ok && std::abs(v) <= wheel_lim;
+        }
+        feasible[k] = ok ? 1 : 0;
+    }
+}
+
+void Wheel_math::calculate_batch(const float *velocity_x, const float *velocity_y,
+                                 const float *velocity_w, size_t n,
+                                 float *const wheel[4], uint8_t *feasible) const {
+    size_t k = 0;
+
+#if defined(WHEEL_MATH_NEON)
+    const float32x4_t x_lim = vdupq_n_f32(static_cast<float>(X_LIMIT));
+    const float32x4_t y_lim = vdupq_n_f32(static_cast<float>(Y_LIMIT));
+    const float32x4_t w_lim = vdupq_n_f32(static_cast<float>(W_LIMIT));
+    const float32x4_t wheel_lim = vdupq_n_f32(static_cast<float>(WHEEL_LIMIT));
+
+    for (; k + 4 <= n; k += 4) {
+        const float32x4_t vx = vld1q_f32(velocity_x + k);
+        const float32x4_t vy = vld1q_f32(velocity_y + k);
+        const float32x4_t vw = vld1q_f32(velocity_w + k);
+
+        uint32x4_t ok = vandq_u32(vcaleq_f32(vx, x_lim), vcaleq_f32(vy, y_lim));
+        ok = vandq_u32(ok, vcaleq_f32(vw, w_lim));
+
+        for (int i = 0; i < 4; i++) {
+            float32x4_t v = vmulq_n_f32(vx, ik_x[i]);
+            v = vmlaq_n_f32(v, vy, ik_y[i]);
+            v = vmlaq_n_f32(v, vw, ik_w[i]);
+            vst1q_f32(wheel[i] + k, v);
+            ok = vandq_u32(ok, vcaleq_f32(v, wheel_lim));
+        }
+
+        // Narrow the 4 x 32 bit lanes to 0/1 bytes
+        const uint16x4_t ok16 = vmovn_u32(vshrq_n_u32(ok, 31));
+        const uint8x8_t ok8 = vmovn_u16(vcombine_u16(ok16, ok16));
+        feasible[k + 0] = vget_lane_u8(ok8, 0);
+        feasible[k + 1] = vget_lane_u8(ok8, 1);
+        feasible[k + 2] = vget_lane_u8(ok8, 2);
+        feasible[k + 3] = vget_lane_u8(ok8, 3);
+    }
+#elif defined(WHEEL_MATH_AVX)
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 x_lim = _mm256_set1_ps(static_cast<float>(X_LIMIT));
+    const __m256 y_lim = _mm256_set1_ps(static_cast<float>(Y_LIMIT));
+    const __m256 w_lim = _mm256_set1_ps(static_cast<float>(W_LIMIT));
+    const __m256 wheel_lim = _mm256_set1_ps(static_cast<float>(WHEEL_LIMIT));
+
+    for (; k + 8 <= n; k += 8) {
+        const __m256 vx = _mm256_loadu_ps(velocity_x + k);
+        const __m256 vy = _mm256_loadu_ps(velocity_y + k);
+        const __m256 vw = _mm256_loadu_ps(velocity_w + k);
+
+        __m256 ok = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_andnot_ps(sign, vx), x_lim, _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_andnot_ps(sign, vy), y_lim, _CMP_LE_OQ));
+        ok = _mm256_and_ps(ok, _mm256_cmp_ps(_mm256_andnot_ps(sign, vw), w_lim, _CMP_LE_OQ));
+
+        for (int i = 0; i < 4; i++) {
+            __m256 v = _mm256_mul_ps(vx, _mm256_set1_ps(ik_x[i]));
+            v = _mm256_add_ps(v, _mm256_mul_ps(vy, _mm256_set1_ps(ik_y[i])));
+            v = _mm256_add_ps(v, _mm256_mul_ps(vw, _mm256_set1_ps(ik_w[i])));
+            _mm256_storeu_ps(wheel[i] + k, v);
+            ok = _mm256_and_ps(ok, _mm256_cmp_ps(_mm256_andnot_ps(sign, v), wheel_lim, _CMP_LE_OQ));
+        }
+
+        const int bits = _mm256_movemask_ps(ok);
+        for (int j = 0; j < 8; j++) {
+            feasible[k + j] = (bits >> j) & 1;
+        }
+    }
+#elif defined(WHEEL_MATH_SSE)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 x_lim = _mm_set1_ps(static_cast<float>(X_LIMIT));
+    const __m128 y_lim = _mm_set1_ps(static_cast<float>(Y_LIMIT));
+    const __m128 w_lim = _mm_set1_ps(static_cast<float>(W_LIMIT));
+    const __m128 wheel_lim = _mm_set1_ps(static_cast<float>(WHEEL_LIMIT));
+
+    for (; k + 4 <= n; k += 4) {
+        const __m128 vx = _mm_loadu_ps(velocity_x + k);
+        const __m128 vy = _mm_loadu_ps(velocity_y + k);
+        const __m128 vw = _mm_loadu_ps(velocity_w + k);
+
+        __m128 ok = _mm_and_ps(_mm_cmple_ps(_mm_andnot_ps(sign, vx), x_lim),
+                               _mm_cmple_ps(_mm_andnot_ps(sign, vy), y_lim));
+        ok = _mm_and_ps(ok, _mm_cmple_ps(_mm_andnot_ps(sign, vw), w_lim));
+
+        for (int i = 0; i < 4; i++) {
+            __m128 v = _mm_mul_ps(vx, _mm_set1_ps(ik_x[i]));
+            v = _mm_add_ps(v, _mm_mul_ps(vy, _mm_set1_ps(ik_y[i])));
+            v = _mm_add_ps(v, _mm_mul_ps(vw, _mm_set1_ps(ik_w[i])));
+            _mm_storeu_ps(wheel[i] + k, v);
+            ok = _mm_and_ps(ok, _mm_cmple_ps(_mm_andnot_ps(sign, v), wheel_lim));
+        }
+
+        const int bits = _mm_movemask_ps(ok);
+        for (int j = 0; j < 4; j++) {
+            feasible[k + j] = (bits >> j) & 1;
+        }
+    }
+#endif
+
+    // Remainder (and the whole batch without SIMD)
+    if (k < n) {
+        float *const tail[4] = {wheel[0] + k, wheel[1] + k, wheel[2] + k, wheel[3] + k};
+        calculate_batch_scalar(velocity_x + k, velocity_y + k, velocity_w + k, n - k,
+                               tail, feasible + k);
+    }
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <unistd.h>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <map>
@@ -27,9 +28,15 @@
 #include "decode.h"
 #include "UDP.h"
 #include "detect_ball.h"
+#include "ball_tracker.h"
 #include "arduino.h"
 #include "Telemetry.h"
 #include "arduino.h"
+#include "slip_detector.h"
+#include "traction_control.h"
+#include "heading_hold.h"
+#include "body_velocity.h"
+#include "motor_supervisor.h"
 #include <yaml-cpp/yaml.h>
 #include "Logger/Logger.h"
 
@@ -45,21 +52,52 @@ static_assert(std::is_trivially_copyable<BallObservation>::value,
 std::atomic<BallObservation> ball_observation{
     BallObservation{false, 0.f, 0.f, 0.f, 0.f, 0.f}};
 
+// Kalman track of the ball, updated by the camera thread; the main loop
+// predicts it forward to its own time with BallTracker::predict().
+static_assert(std::is_trivially_copyable<BallTracker::State>::value,
+              "BallTracker::State must be trivially copyable for std::atomic");
+std::atomic<BallTracker::State> ball_track{BallTracker::State{}};
+
 // --- Forward declaration for signal handler ---
 void signalHandler(int signum);
 
 // --- Thread function for camera detection ---
-void CameraThread(BallDetection &detector)
+// BallDetection's capture thread keeps the newest frame; this runs the
+// detector on it at most once per Camera_interval (0 = every new frame)
+// and feeds the result to the tracker.
+void CameraThread(BallDetection &detector, BallTracker &tracker, std::chrono::milliseconds interval)
 {
+    auto next_run = std::chrono::steady_clock::now();
     while (!stop_camera_thread.load(std::memory_order_relaxed))
     {
-        BallObservation obs = detector.observe();
+        std::this_thread::sleep_until(next_run);
+
+        BallObservation obs;
+        const auto start = std::chrono::steady_clock::now();
+        if (!detector.observeLatest(obs))
+        {
+            // No new frame yet
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        tracker.update(obs, obs.stamp_ns);
         ball_observation.store(obs, std::memory_order_relaxed);
+        ball_track.store(tracker.state(), std::memory_order_relaxed);
         ball_detected.store(obs.found, std::memory_order_relaxed);
-        std::this_thread::sleep_for(std::chrono::milliseconds(300)); // Reduce CPU usage
+        next_run = start + interval;
     }
 }
 
+// Age of an observation at `now` in ms, from its frame's capture time;
+// -1 before the first processed frame.
+static double observationAgeMs(const BallObservation &obs, std::chrono::steady_clock::time_point now)
+{
+    if (obs.stamp_ns == 0) return -1.0;
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now.time_since_epoch()).count();
+    return (now_ns - obs.stamp_ns) / 1e6;
+}
+
 // --- Struct for telemetry message to send ---
 struct Telemetry_msg
 {
@@ -161,7 +199,7 @@ int main(int argc, char **argv)
         interval_reciver = 5;
         interval_sender = 1000;
         interval_arduino = 100;
-        interval_camera = 200;
+        interval_camera = 33;
         interval_motor = 20;
 
         current_limit = 5.0;
@@ -191,15 +229,23 @@ int main(int argc, char **argv)
 
     // --- Initialize modules ---
     BallDetection detect; // Camera detection
+    BallTracker tracker;  // Ball track over the camera detections
     UDP UDP;              // UDP communication
     Wheel_math m;         // Wheel velocity calculations
     cmdDecoder cmd;       // Decode incoming commands
     Telemetry telemetry;  // Motor telemetry
     Arduino a;            // Arduino controller
+    SlipDetector slip;            // Per-wheel slip/stall classification
+    TractionController traction;  // Backs off acceleration on lost traction
+    HeadingHold heading;          // IMU yaw correction on velocity_w
+    BodyVelocityController body;  // Closed-loop body twist from odometry + gyro
+    MotorSupervisor supervisor;   // Per-motor fault states, derating and re-arm
 
     std::string msg;                    // Incoming UDP message
     std::vector<double> wheel_velocity; // Calculated wheel velocities
     std::map<int, double> velocity_map; // Motor ID → velocity map
+    std::map<int, double> drive_map = {{1, zero}, {2, zero}, {3, zero}, {4, zero}}; // Traction-limited commands sent to motors
+    std::map<int, double> target_map = {{1, zero}, {2, zero}, {3, zero}, {4, zero}}; // Wheel targets, re-solved while a motor is out
     Telemetry_msg sender_msg;           // Telemetry message to send
 
     // Set mode of Wheel_math based on flags
@@ -225,13 +271,16 @@ int main(int argc, char **argv)
     // }
 
     bool emergency_stop = false; // Flag to stop robot on emergency
+    bool drive_active = false;   // True while following a received velocity command
+    double measured_wheels[4] = {0.0, 0.0, 0.0, 0.0}; // Last measured wheel velocities
+    std::map<int, LinkHealth::State> link_states;        // Last logged CAN link state per motor
 
     // --- Start camera detection thread ---
     std::thread camera_thread;
-    if (detect.open_cam() > 0)
+    if (detect.open_cam() > 0 && detect.startCapture())
     {
         // I didnt detach this beacsue it wanted to close it later on.
-        camera_thread = std::thread(CameraThread, std::ref(detect));
+        camera_thread = std::thread(CameraThread, std::ref(detect), std::ref(tracker), CameraInterval);
         logger.log("rframework", "camball", "Camera thread started", LogLevel::INFO);
     }
 
@@ -246,6 +295,15 @@ int main(int argc, char **argv)
     }
     logger.log("rframework", "Sent stop to all controllers", LogLevel::DONE);
 
+    // Motors that missed bus discovery are still driven on their
+    // configured bus, LinkHealth brings them in once they answer
+    for (int id : telemetry.missingMotors())
+    {
+        logger.log("rframework", std::string("motor-") + std::to_string(id),
+            "Not found by bus discovery, driving on the configured bus until it answers",
+            LogLevel::CRIT);
+    }
+
     // --- Log UDP ports ---
     logger.log("rframework", std::string("Sending port at: ") + 
         std::to_string(UDP.getSenderPort()), LogLevel::LOVE);
@@ -281,6 +339,9 @@ int main(int argc, char **argv)
                 {
                     logger.log("rframework", "reciever", "UDP TIMEOUT - stopping motors", LogLevel::WARN);
                     velocity_map = {{1, zero}, {2, zero}, {3, zero}, {4, zero}}; // Stop wheels
+                    drive_active = false;
+                    heading.reset();
+                    body.reset();
                 }
             }
             else if (msg == "STOP")
@@ -309,6 +370,7 @@ int main(int argc, char **argv)
                     {2, wheel_velocity[1]},
                     {3, wheel_velocity[2]},
                     {4, wheel_velocity[3]}};
+                drive_active = true;
 
                 last_known_message = current_time;
             }
@@ -327,7 +389,12 @@ int main(int argc, char **argv)
                 " py=" + std::to_string(obs.py) +
                 " r="  + std::to_string(obs.radius) +
                 " b="  + std::to_string(obs.bearing) +
-                " c="  + std::to_string(obs.confidence),
+                " c="  + std::to_string(obs.confidence) +
+                (obs.ground ? " x=" + std::to_string(obs.x) + " y=" + std::to_string(obs.y) : std::string()) +
+                " rr=" + std::to_string(obs.range_radius) +
+                " seq=" + std::to_string(obs.sequence) +
+                " proc_us=" + std::to_string(obs.process_us) +
+                " age_ms=" + std::to_string(observationAgeMs(obs, current_time)),
                 LogLevel::INFO);
             last_camera_time = current_time;
         }
@@ -340,15 +407,99 @@ int main(int argc, char **argv)
         // --- Motor Telemetry and Safety Check ---
         if (current_time - last_motor_time >= MotorInterval)
         {
-            auto servo_status = telemetry.cycle(velocity_map); // Send commands & receive telemetry
+            double dt = std::chrono::duration<double>(current_time - last_motor_time).count();
+
+            // Heading hold and body velocity loop: re-solve the wheels with
+            // the corrected twist
+            const ImuTelemetry &imu = telemetry.imu();
+            bool heading_active = heading.enabled() && imu.present;
+            if (drive_active && (heading_active || body.enabled()))
+            {
+                BodyVelocityController::Twist twist;
+                twist.x = cmd.velocity_x;
+                twist.y = cmd.velocity_y;
+                twist.w = cmd.velocity_w;
+                if (heading_active)
+                {
+                    twist.w = heading.update(cmd.velocity_w, imu.yaw, imu.yaw_rate,
+                                             dt, m.getWLimit());
+                }
+
+                BodyVelocityController::Twist odometry, limit;
+                m.forward(measured_wheels, odometry.x, odometry.y, odometry.w);
+                limit.x = m.getXLimit();
+                limit.y = m.getYLimit();
+                limit.w = m.getWLimit();
+                twist = body.update(twist, odometry, imu.yaw_rate, imu.present, dt, limit);
+
+                wheel_velocity = m.calculate(twist.x, twist.y, twist.w);
+                velocity_map = {
+                    {1, wheel_velocity[0]},
+                    {2, wheel_velocity[1]},
+                    {3, wheel_velocity[2]},
+                    {4, wheel_velocity[3]}};
+            }
+
+            // One motor out: drive the same twist on the other three
+            int stopped_wheel = -1;
+            int stopped_count = 0;
+            for (int id = 1; id <= 4; id++)
+            {
+                auto it = velocity_map.find(id);
+                target_map[id] = (it != velocity_map.end()) ? it->second : zero;
+                if (supervisor.stopped(id))
+                {
+                    stopped_wheel = id - 1;
+                    stopped_count++;
+                }
+            }
+            if (stopped_count == 1)
+            {
+                double wheels[4], solved[4];
+                for (int id = 1; id <= 4; id++)
+                    wheels[id - 1] = target_map[id];
+                m.solve_without(wheels, stopped_wheel, solved);
+                for (int id = 1; id <= 4; id++)
+                    target_map[id] = solved[id - 1];
+            }
+
+            // Rate-limit wheel commands, backing off while traction is lost
+            traction.apply(target_map, drive_map, slip, dt);
 
-            float voltage[4];
-            int i = 0;
+            // Drive on at the scale of the most derated motor so the twist
+            // keeps its direction, faulted motors are held stopped below
+            const double drive_scale = supervisor.driveScale();
+            if (drive_scale < 1.0)
+            {
+                for (auto &pair : drive_map)
+                    pair.second *= drive_scale;
+            }
+
+            // A motor held stopped is sent stop, so record zero for it: the
+            // slip detector would otherwise see its command against a
+            // standing wheel, and after re-arm it ramps up from zero
+            for (auto &pair : drive_map)
+            {
+                if (supervisor.stopped(pair.first))
+                {
+                    pair.second = zero;
+                    traction.resetWheel(pair.first);
+                }
+            }
+
+            auto servo_status = telemetry.cycle(drive_map); // Send commands & receive telemetry
+
+            float voltage_sum = 0;
+            int voltage_count = 0;
 
             for (const auto &pair : servo_status)
             {
                 const auto &r = pair.second;
-                voltage[i] = r.voltage;
+                if (std::isfinite(r.voltage))
+                {
+                    voltage_sum += r.voltage;
+                    voltage_count++;
+                }
                 int motor_id = pair.first;
 
                 std::string sub = std::string("motor-") + std::to_string(motor_id);
@@ -357,24 +508,78 @@ int main(int argc, char **argv)
                     {"voltage", r.voltage},
                     {"velocity", r.velocity},
                     {"current", r.current},
-                    {"mode", static_cast<double>(r.mode)}};
+                    {"mode", static_cast<double>(r.mode)},
+                    {"fault", static_cast<double>(r.fault)}};
                 logger.log("rframework", sub, data, "", LogLevel::INFO);
 
                 // std::cout << "Motor ID: " << motor_id << " Position is: " << r.position << " Mode is: "<< r.mode<< " Velocity is: " << r.velocity<< " Current is: "<< r.current<<"\n";
 
-                if (r.current > current_limit)
+                if (motor_id >= 1 && motor_id <= 4 && std::isfinite(r.velocity))
+                    measured_wheels[motor_id - 1] = r.velocity;
+
+                // Compare what this wheel was sent against what it did
+                auto cmd_it = drive_map.find(motor_id);
+                double commanded = (cmd_it != drive_map.end()) ? cmd_it->second : zero;
+                SlipDetector::State previous = slip.state(motor_id);
+                SlipDetector::State state = slip.update(motor_id, commanded, r.velocity, r.current);
+                if (state != previous)
+                {
+                    logger.log("rframework", sub,
+                        std::string("Traction ") + SlipDetector::stateToString(previous) +
+                        " -> " + SlipDetector::stateToString(state) +
+                        " (accel scale " + std::to_string(traction.scale()) + ")",
+                        state == SlipDetector::State::GRIP ? LogLevel::INFO : LogLevel::WARN);
+                }
+
+                // Overcurrent, overtemperature and moteus faults take this
+                // motor out for faultyGrace instead of stopping the robot
+                MotorSupervisor::State previous_supervised = supervisor.state(motor_id);
+                MotorSupervisor::State supervised =
+                    supervisor.update(motor_id, r.mode, r.fault, r.current, r.temperature, dt);
+                if (supervised != previous_supervised)
                 {
-                    logger.log("rframework", sub, "Overcurrent detected", LogLevel::CRIT);
-                    emergency_stop = true;
+                    logger.log("rframework", sub,
+                        std::string("Supervisor ") + MotorSupervisor::stateToString(previous_supervised) +
+                        " -> " + MotorSupervisor::stateToString(supervised) +
+                        " (" + supervisor.reason(motor_id) +
+                        ", fault " + std::to_string(supervisor.faultCode(motor_id)) +
+                        (supervisor.latched(motor_id) ? ", latched" : "") + ")",
+                        supervised == MotorSupervisor::State::FAULTED ? LogLevel::CRIT :
+                        supervised == MotorSupervisor::State::OK ? LogLevel::INFO : LogLevel::WARN);
                 }
-                i++;
             }
 
-            // Compute average voltage
-            float sum = 0;
-            for (int i = 0; i < 4; i++)
-                sum += voltage[i];
-            sender_msg.voltage = sum / 4;
+            for (const auto &pair : telemetry.controllers)
+                telemetry.holdStopped(pair.first, supervisor.stopped(pair.first));
+
+            if (supervisor.escalate())
+            {
+                logger.log("rframework", "Too many motors faulted to keep driving", LogLevel::CRIT);
+                emergency_stop = true;
+            }
+
+            // Average voltage over the motors that replied, keep the last
+            // value if none did
+            if (voltage_count > 0)
+                sender_msg.voltage = voltage_sum / voltage_count;
+
+            // CAN link health: log state changes with the reason
+            for (const auto &pair : telemetry.controllers)
+            {
+                const LinkHealth::Status &h = telemetry.linkHealth().status(pair.first);
+                LinkHealth::State &logged = link_states[pair.first];
+                if (h.state != logged)
+                {
+                    logger.log("rframework", std::string("motor-") + std::to_string(pair.first),
+                        std::string("Link ") + LinkHealth::stateToString(logged) +
+                        " -> " + LinkHealth::stateToString(h.state) +
+                        " (missed " + std::to_string(h.missed) + "/" + std::to_string(h.sent) +
+                        ", fault " + std::to_string(h.fault) +
+                        ", recoveries " + std::to_string(h.recoveries) + ")",
+                        h.state == LinkHealth::State::OK ? LogLevel::INFO : LogLevel::WARN);
+                    logged = h.state;
+                }
+            }
 
             // std::cout << sender_msg.voltage << "\n";
 
@@ -385,18 +590,80 @@ int main(int argc, char **argv)
         if (current_time - last_sender_time >= Sender_interval)
         {
             // key=value telemetry so external PC can parse deterministically.
-            // Fields: state, voltage, ball (0/1), px, py, radius, bearing, conf, ts_ms.
+            // Fields: state, voltage, links_bad, link_missed, can_p99_us, can_max_us, ball (0/1), px, py, radius, bearing, conf,
+            // gnd (0/1), gx, gy (ball on the floor, robot frame, m), grr (floor range from ball size, m),
+            // age_ms (since the observation's frame was captured, -1 = none yet), proc_us (its detection time),
+            // trk (0/1), tx, ty, tvx, tvy (tracked ball predicted to now, px and px/s), tsd (position std dev, px), ts_ms.
             auto ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                 current_time.time_since_epoch()).count();
+            const BallEstimate est = tracker.predict(
+                ball_track.load(std::memory_order_relaxed),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(current_time.time_since_epoch()).count());
+            // CAN cycle performance since the last report
+            mjbots::pi3hat::Pi3HatMoteusTransport::Statistics perf;
+            if (telemetry.pi3hat_transport) perf = telemetry.pi3hat_transport->statistics(true);
+            // Counters for the next report, read now while no cycle is running
+            if (telemetry.devicePerformanceEnabled()) telemetry.pi3hat_transport->request_device_performance();
+            if (perf.total.count > 0)
+            {
+                std::map<std::string, double> perf_data = {
+                    {"cycles", static_cast<double>(perf.total.count)},
+                    {"total_mean_us", static_cast<double>(perf.total.MeanUs())},
+                    {"total_p99_us", static_cast<double>(perf.total.PercentileUs(99.0))},
+                    {"total_max_us", perf.total.max_ns / 1000.0},
+                    {"flush_p99_us", static_cast<double>(perf.flush.PercentileUs(99.0))},
+                    {"send_p99_us", static_cast<double>(perf.send.PercentileUs(99.0))},
+                    {"attitude_p99_us", static_cast<double>(perf.rf_attitude.PercentileUs(99.0))},
+                    {"read_p99_us", static_cast<double>(perf.read.PercentileUs(99.0))}};
+                for (int bus = 1; bus < 6; bus++)
+                {
+                    if (perf.tx_frames[bus] == 0 && perf.rx_frames[bus] == 0) continue;
+                    perf_data["bus" + std::to_string(bus) + "_tx"] = static_cast<double>(perf.tx_frames[bus]);
+                    perf_data["bus" + std::to_string(bus) + "_rx"] = static_cast<double>(perf.rx_frames[bus]);
+                    perf_data["bus" + std::to_string(bus) + "_wire_us"] = static_cast<double>(perf.CanWireMeanUs(bus));
+                    perf_data["bus" + std::to_string(bus) + "_wire_max_us"] = perf.can_wire_max_ns[bus] / 1000.0;
+                }
+                if (perf.device_performance_valid)
+                {
+                    perf_data["can1_min_cycles_per_ms"] = perf.device_performance.can1.min_cycles_per_ms;
+                    perf_data["can2_min_cycles_per_ms"] = perf.device_performance.can2.min_cycles_per_ms;
+                }
+                logger.log("rframework", "canperf", perf_data, "", LogLevel::INFO);
+            }
+
+            int links_bad = 0;
+            uint64_t link_missed = 0;
+            for (const auto &pair : telemetry.controllers)
+            {
+                const LinkHealth::Status &h = telemetry.linkHealth().status(pair.first);
+                if (h.state != LinkHealth::State::OK) links_bad++;
+                link_missed += h.missed;
+            }
             std::string msg =
                 "state=active"
                 ",voltage=" + std::to_string(sender_msg.voltage) +
+                ",links_bad="   + std::to_string(links_bad) +
+                ",link_missed=" + std::to_string(link_missed) +
+                ",can_p99_us="  + std::to_string(perf.total.PercentileUs(99.0)) +
+                ",can_max_us="  + std::to_string(perf.total.max_ns / 1000) +
                 ",ball="    + (sender_msg.obs.found ? "1" : "0") +
                 ",px="      + std::to_string(sender_msg.obs.px) +
                 ",py="      + std::to_string(sender_msg.obs.py) +
                 ",r="       + std::to_string(sender_msg.obs.radius) +
                 ",bearing=" + std::to_string(sender_msg.obs.bearing) +
                 ",conf="    + std::to_string(sender_msg.obs.confidence) +
+                ",gnd="     + (sender_msg.obs.ground ? "1" : "0") +
+                ",gx="      + std::to_string(sender_msg.obs.x) +
+                ",gy="      + std::to_string(sender_msg.obs.y) +
+                ",grr="     + std::to_string(sender_msg.obs.range_radius) +
+                ",age_ms="  + std::to_string(observationAgeMs(sender_msg.obs, current_time)) +
+                ",proc_us=" + std::to_string(sender_msg.obs.process_us) +
+                ",trk="     + (est.valid ? "1" : "0") +
+                ",tx="      + std::to_string(est.x) +
+                ",ty="      + std::to_string(est.y) +
+                ",tvx="     + std::to_string(est.vx) +
+                ",tvy="     + std::to_string(est.vy) +
+                ",tsd="     + std::to_string(std::sqrt(std::max(est.cov_x[0], est.cov_y[0]))) +
                 ",ts_ms="   + std::to_string(ts_ms);
             logger.log("rframework", "sender", msg, LogLevel::INFO);
             UDP.send(msg);
@@ -448,6 +715,7 @@ int main(int argc, char **argv)
     {
         camera_thread.join();
     }
+    detect.stopCapture();
 
     std::cout << "Emergency Stop has been activated\n";
     logger.closeAll();
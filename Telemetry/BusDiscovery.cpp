@@ -0,0 +1,252 @@
+#include "BusDiscovery.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+namespace
+{
+constexpr int kBroadcastId = 0x7f;
+constexpr int kNumBuses = 5;
+
+// Mode only: the smallest reply a controller can give
+mjbots::moteus::Query::Format probeFormat()
+{
+    using mjbots::moteus::Resolution;
+    mjbots::moteus::Query::Format format;
+    format.position = Resolution::kIgnore;
+    format.velocity = Resolution::kIgnore;
+    format.torque = Resolution::kIgnore;
+    format.voltage = Resolution::kIgnore;
+    format.temperature = Resolution::kIgnore;
+    format.fault = Resolution::kIgnore;
+    return format;
+}
+
+mjbots::moteus::CanFdFrame makeProbe(int id, int bus)
+{
+    mjbots::moteus::Controller::Options opts;
+    opts.id = id;
+    opts.bus = bus;
+    opts.query_format = probeFormat();
+    return mjbots::moteus::Controller(opts).MakeQuery();
+}
+
+std::string hex(const uint8_t *data, size_t size)
+{
+    std::string result;
+    char buf[3];
+    for (size_t i = 0; i < size; i++)
+    {
+        std::snprintf(buf, sizeof(buf), "%02x", data[i]);
+        result += buf;
+    }
+    return result;
+}
+}
+
+BusDiscovery::BusDiscovery()
+{
+    initalize_discovery();
+}
+
+void BusDiscovery::initalize_discovery()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Motor.yaml");
+        YAML::Node discovery = config["discovery"];
+
+        is_enabled = discovery["enabled"].as<bool>();
+        cache_path = discovery["cachePath"].as<std::string>();
+        probe_timeout_us = discovery["probeTimeoutUs"].as<uint32_t>();
+        probe_rounds = discovery["probeRounds"].as<int>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading discovery config: " << e.what() << std::endl;
+        is_enabled = false;
+        cache_path = "../config/MotorCache.yaml";
+        probe_timeout_us = 2000;
+        probe_rounds = 3;
+    }
+
+    if (probe_rounds < 1) probe_rounds = 1;
+}
+
+std::map<int, int> BusDiscovery::resolve(const std::map<int, int> &configured,
+                                         mjbots::pi3hat::Pi3HatMoteusTransport::Options toptions)
+{
+    missing_ids.clear();
+    if (!is_enabled) return configured;
+
+    // Frames must go to the bus they name, not a mapped one
+    toptions.servo_map.clear();
+
+    std::map<int, int> found;
+    {
+        mjbots::pi3hat::Pi3HatMoteusTransport transport(toptions);
+        const auto info = transport.device_info();
+
+        if (!info.can_unknown_address_safe)
+        {
+            std::cerr << "Discovery: pi3hat firmware is not safe to probe (BUG-ID-1), "
+                      << "using motorMap from Motor.yaml" << std::endl;
+            return configured;
+        }
+
+        const std::string print = fingerprint(info);
+        if (loadCache(print, found) && validate(transport, found))
+        {
+            std::cout << "Discovery: cached topology confirmed\n";
+        }
+        else
+        {
+            found = scan(transport);
+            saveCache(print, found);
+            std::cout << "Discovery: scanned " << found.size() << " servo(s)\n";
+        }
+    }
+
+    std::map<int, int> result;
+    for (const auto &p : configured)
+    {
+        auto it = found.find(p.first);
+        if (it == found.end())
+        {
+            std::cerr << "Discovery: motor " << p.first << " not found on any bus, keeping it on bus "
+                      << p.second << " from motorMap" << std::endl;
+            missing_ids.push_back(p.first);
+            result[p.first] = p.second;
+            continue;
+        }
+        if (it->second != p.second)
+        {
+            std::cout << "Discovery: motor " << p.first << " is on bus " << it->second
+                      << " (motorMap says " << p.second << ")\n";
+        }
+        result[p.first] = it->second;
+    }
+    for (const auto &p : found)
+    {
+        if (configured.count(p.first) == 0)
+        {
+            std::cout << "Discovery: ignoring servo " << p.first << " on bus " << p.second
+                      << ", not in motorMap\n";
+        }
+    }
+    return result;
+}
+
+std::string BusDiscovery::fingerprint(const mjbots::pi3hat::Pi3Hat::DeviceInfo &info)
+{
+    // Board serials plus firmware, a reflash also invalidates the cache
+    return hex(info.can1.serial_number, sizeof(info.can1.serial_number)) + "-" +
+           hex(info.can2.serial_number, sizeof(info.can2.serial_number)) + "-" +
+           hex(info.can1.git_hash, 4) + hex(info.can2.git_hash, 4);
+}
+
+bool BusDiscovery::loadCache(const std::string &expected_fingerprint, std::map<int, int> &found)
+{
+    found.clear();
+    try
+    {
+        YAML::Node cache = YAML::LoadFile(cache_path);
+        if (cache["fingerprint"].as<std::string>() != expected_fingerprint) return false;
+
+        YAML::Node motors = cache["motorMap"];
+        for (YAML::const_iterator it = motors.begin(); it != motors.end(); ++it)
+        {
+            found[it->first.as<int>()] = it->second.as<int>();
+        }
+    }
+    catch (const std::exception &)
+    {
+        // No cache yet (or unreadable), scan instead
+        found.clear();
+        return false;
+    }
+    return !found.empty();
+}
+
+void BusDiscovery::saveCache(const std::string &fingerprint, const std::map<int, int> &found)
+{
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    out << YAML::Key << "fingerprint" << YAML::Value << fingerprint;
+    out << YAML::Key << "motorMap" << YAML::Value << YAML::BeginMap;
+    for (const auto &p : found)
+    {
+        out << YAML::Key << p.first << YAML::Value << p.second;
+    }
+    out << YAML::EndMap << YAML::EndMap;
+
+    std::ofstream file(cache_path);
+    if (!file)
+    {
+        std::cerr << "Discovery: could not write " << cache_path << std::endl;
+        return;
+    }
+    file << "# Written by BusDiscovery, delete to force a rescan\n" << out.c_str() << "\n";
+}
+
+mjbots::pi3hat::Pi3Hat::Input BusDiscovery::probeInput() const
+{
+    mjbots::pi3hat::Pi3Hat::Input input;
+    input.timeout_ns = probe_timeout_us * 1000;
+    input.min_tx_wait_ns = probe_timeout_us * 1000;
+    // Keep listening while broadcast replies are still arriving
+    input.rx_extra_wait_ns = 200000;
+    input.force_can_check = 0x3e;  // buses 1-5
+    return input;
+}
+
+bool BusDiscovery::validate(mjbots::pi3hat::Pi3HatMoteusTransport &transport,
+                            const std::map<int, int> &servo_map)
+{
+    std::vector<mjbots::moteus::CanFdFrame> frames;
+    for (const auto &p : servo_map)
+    {
+        frames.push_back(makeProbe(p.first, p.second));
+    }
+
+    std::vector<mjbots::moteus::CanFdFrame> replies;
+    mjbots::pi3hat::Pi3Hat::Input input = probeInput();
+    mjbots::moteus::BlockingCallback cbk;
+    transport.Cycle(frames.data(), frames.size(), &replies, nullptr, nullptr, &input, cbk.callback());
+    cbk.Wait();
+
+    std::map<int, int> seen;
+    for (const auto &frame : replies)
+    {
+        seen[frame.source] = frame.bus;
+    }
+    return seen == servo_map;
+}
+
+std::map<int, int> BusDiscovery::scan(mjbots::pi3hat::Pi3HatMoteusTransport &transport)
+{
+    std::vector<mjbots::moteus::CanFdFrame> frames;
+    for (int bus = 1; bus <= kNumBuses; bus++)
+    {
+        frames.push_back(makeProbe(kBroadcastId, bus));
+    }
+
+    std::map<int, int> found;
+    std::vector<mjbots::moteus::CanFdFrame> replies;
+    for (int round = 0; round < probe_rounds; round++)
+    {
+        mjbots::pi3hat::Pi3Hat::Input input = probeInput();
+        mjbots::moteus::BlockingCallback cbk;
+        transport.Cycle(frames.data(), frames.size(), &replies, nullptr, nullptr, &input, cbk.callback());
+        cbk.Wait();
+
+        for (const auto &frame : replies)
+        {
+            found[frame.source] = frame.bus;
+        }
+    }
+    return found;
+}
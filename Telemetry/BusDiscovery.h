@@ -0,0 +1,70 @@
+#ifndef BUS_DISCOVERY_H
+#define BUS_DISCOVERY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "moteus.h"
+#include "pi3hat_moteus_transport.h"
+
+// Finds which CAN bus each moteus controller is really on.
+//
+// Older pi3hat firmware soft-faults when a frame goes to an unpopulated
+// bus or an ID nothing acknowledges (docs/known_issues/BUG-ID-1.md), so
+// the configured motorMap is only trusted after it has been checked:
+//
+//   1. If the cache (discovery.cachePath) was written on this pi3hat,
+//      query every cached servo once.  All of them answering on the
+//      cached bus means the cache is used as is.
+//   2. Otherwise, and only when the firmware reports
+//      can_unknown_address_safe, send a broadcast query on every bus and
+//      collect the replies, then store the result in the cache.
+//   3. Unsafe firmware is never probed: the configured map is used.
+//
+// Probing uses its own short-lived transport with an empty servo_map so
+// every frame goes to the bus it names.
+class BusDiscovery
+{
+public:
+    BusDiscovery();
+    ~BusDiscovery() = default;
+
+    bool enabled() const { return is_enabled; }
+
+    // Returns the id -> bus map to run with.  Only configured motor IDs
+    // are kept, moved to the bus they were found on.  Configured IDs that
+    // did not answer stay on their configured bus, so a controller that
+    // powers up late is still driven and LinkHealth can bring it back;
+    // they are listed in missing().  Probing only runs on firmware that
+    // is safe to address unknown IDs, so keeping them is harmless.
+    std::map<int, int> resolve(const std::map<int, int> &configured,
+                               mjbots::pi3hat::Pi3HatMoteusTransport::Options toptions);
+
+    // Configured motor IDs that did not answer the last resolve()
+    const std::vector<int> &missing() const { return missing_ids; }
+
+private:
+    bool is_enabled;
+    std::string cache_path;
+    uint32_t probe_timeout_us;
+    int probe_rounds;
+    std::vector<int> missing_ids;
+
+    void initalize_discovery();
+
+    static std::string fingerprint(const mjbots::pi3hat::Pi3Hat::DeviceInfo &info);
+    bool loadCache(const std::string &expected_fingerprint, std::map<int, int> &found);
+    void saveCache(const std::string &fingerprint, const std::map<int, int> &found);
+
+    // One cycle: query each servo on its bus, true if every one replied
+    // from that bus.
+    bool validate(mjbots::pi3hat::Pi3HatMoteusTransport &transport,
+                  const std::map<int, int> &servo_map);
+    // Broadcast query on every bus, returns every (id, bus) that replied.
+    std::map<int, int> scan(mjbots::pi3hat::Pi3HatMoteusTransport &transport);
+
+    mjbots::pi3hat::Pi3Hat::Input probeInput() const;
+};
+
+#endif // BUS_DISCOVERY_H
@@ -0,0 +1,162 @@
+#ifndef FIXED_REPLY_PARSER_H
+#define FIXED_REPLY_PARSER_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "moteus.h"
+
+// Straight-line decoder for a query reply whose layout is known at
+// compile time.
+//
+// Query::Parse() walks the multiplex stream and switches on every
+// register and resolution at run time.  Telemetry always asks for the
+// same registers, so the reply layout is fixed: a FixedReplyParser lists
+// the reply blocks as template arguments and decodes them with constant
+// offsets.  parse() checks every block header and returns false on any
+// difference, the caller then falls back to Query::Parse().
+//
+//   using Reply = FixedReplyParser<ReplyBlock<Register::kMode, kInt8>,
+//                                  ReplyBlock<Register::kVoltage, kInt8, 3>>;
+
+// `Count` consecutive registers starting at `Reg`, all at `Res`.
+template <uint16_t Reg, mjbots::moteus::Resolution Res, uint8_t Count = 1>
+struct ReplyBlock
+{
+    static_assert(Count > 0, "empty reply block");
+    static_assert(Reg + Count <= 0x80, "register must fit a one byte varuint");
+    static_assert(Res != mjbots::moteus::Resolution::kIgnore, "ignored registers have no block");
+
+    static constexpr uint8_t kValueSize =
+        Res == mjbots::moteus::Resolution::kInt8 ? 1 :
+        Res == mjbots::moteus::Resolution::kInt16 ? 2 : 4;
+    static constexpr uint8_t kHeaderSize = Count <= 3 ? 2 : 3;
+    static constexpr uint8_t kSize = kHeaderSize + Count * kValueSize;
+
+    // Header of this block with the given base (read request or reply)
+    static uint8_t writeHeader(uint8_t base, uint8_t *out)
+    {
+        uint8_t n = 0;
+        out[n++] = static_cast<uint8_t>(base | (static_cast<uint8_t>(Res) << 2) | (Count <= 3 ? Count : 0));
+        if (Count > 3) out[n++] = Count;
+        out[n++] = static_cast<uint8_t>(Reg);
+        return n;
+    }
+
+    static bool parse(const uint8_t *data, uint8_t &offset, mjbots::moteus::Query::Result *out)
+    {
+        uint8_t header[3];
+        const uint8_t header_size = writeHeader(mjbots::moteus::Multiplex::kReplyBase, header);
+        if (std::memcmp(&data[offset], header, header_size) != 0) return false;
+        offset += header_size;
+
+        store(&data[offset], out, std::make_integer_sequence<uint16_t, Count>());
+        offset += Count * kValueSize;
+        return true;
+    }
+
+private:
+    template <typename T>
+    static T load(const uint8_t *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    static double nanify(T value, double scale)
+    {
+        if (value == std::numeric_limits<T>::min()) return std::numeric_limits<double>::quiet_NaN();
+        return value * scale;
+    }
+
+    // Scales match MultiplexParser::ReadConcrete()
+    static double mapped(const uint8_t *data, double int8_scale, double int16_scale, double int32_scale)
+    {
+        using mjbots::moteus::Resolution;
+        if (Res == Resolution::kInt8) return nanify(load<int8_t>(data), int8_scale);
+        if (Res == Resolution::kInt16) return nanify(load<int16_t>(data), int16_scale);
+        if (Res == Resolution::kInt32) return nanify(load<int32_t>(data), int32_scale);
+        return load<float>(data);
+    }
+
+    static int integer(const uint8_t *data)
+    {
+        using mjbots::moteus::Resolution;
+        if (Res == Resolution::kInt8) return load<int8_t>(data);
+        if (Res == Resolution::kInt16) return load<int16_t>(data);
+        if (Res == Resolution::kInt32) return load<int32_t>(data);
+        return static_cast<int>(load<float>(data));
+    }
+
+    template <uint16_t R>
+    static void storeOne(const uint8_t *data, mjbots::moteus::Query::Result *out)
+    {
+        using namespace mjbots::moteus;
+        if constexpr (R == Register::kMode) out->mode = static_cast<Mode>(integer(data));
+        else if constexpr (R == Register::kPosition) out->position = mapped(data, 0.01, 0.0001, 0.00001);
+        else if constexpr (R == Register::kVelocity) out->velocity = mapped(data, 0.1, 0.00025, 0.00001);
+        else if constexpr (R == Register::kTorque) out->torque = mapped(data, 0.5, 0.01, 0.001);
+        else if constexpr (R == Register::kQCurrent) out->q_current = mapped(data, 1.0, 0.1, 0.001);
+        else if constexpr (R == Register::kDCurrent) out->d_current = mapped(data, 1.0, 0.1, 0.001);
+        else if constexpr (R == Register::kAbsPosition) out->abs_position = mapped(data, 0.01, 0.0001, 0.00001);
+        else if constexpr (R == Register::kPower) out->power = mapped(data, 10.0, 0.05, 0.0001);
+        else if constexpr (R == Register::kMotorTemperature) out->motor_temperature = mapped(data, 1.0, 0.1, 0.001);
+        else if constexpr (R == Register::kTrajectoryComplete) out->trajectory_complete = integer(data) != 0;
+        else if constexpr (R == Register::kHomeState) out->home_state = static_cast<HomeState>(integer(data));
+        else if constexpr (R == Register::kVoltage) out->voltage = mapped(data, 0.5, 0.1, 0.001);
+        else if constexpr (R == Register::kTemperature) out->temperature = mapped(data, 1.0, 0.1, 0.001);
+        else if constexpr (R == Register::kFault) out->fault = static_cast<int8_t>(integer(data));
+        // Anything else is skipped, like Query::Parse() does without extras
+    }
+
+    template <uint16_t... I>
+    static void store(const uint8_t *data, mjbots::moteus::Query::Result *out,
+                      std::integer_sequence<uint16_t, I...>)
+    {
+        (storeOne<Reg + I>(data + I * kValueSize, out), ...);
+    }
+};
+
+template <typename... Blocks>
+struct FixedReplyParser
+{
+    static constexpr uint8_t kSize = (Blocks::kSize + ...);
+
+    // True if `format` produces exactly this reply layout.  Checked once
+    // when the query format is chosen, not per reply.
+    static bool matches(const mjbots::moteus::Query::Format &format)
+    {
+        using namespace mjbots::moteus;
+        CanData request;
+        WriteCanData writer(&request);
+        Query::Make(&writer, format);
+
+        uint8_t expected[64];
+        uint8_t size = 0;
+        ((size += Blocks::writeHeader(Multiplex::kReadBase, &expected[size])), ...);
+        return size == request.size && std::memcmp(expected, request.data, size) == 0;
+    }
+
+    // Decodes a reply into `out`.  Returns false, leaving `out` partly
+    // written, if the reply does not have this layout.
+    static bool parse(const uint8_t *data, uint8_t size, mjbots::moteus::Query::Result *out)
+    {
+        if (size < kSize) return false;
+
+        uint8_t offset = 0;
+        if (!(Blocks::parse(data, offset, out) && ...)) return false;
+
+        // Only CAN-FD padding may follow
+        for (; offset < size; offset++)
+        {
+            if (data[offset] != mjbots::moteus::Multiplex::kNop) return false;
+        }
+        return true;
+    }
+};
+
+#endif // FIXED_REPLY_PARSER_H
@@ -0,0 +1,75 @@
+#ifndef FRAME_TEMPLATE_H
+#define FRAME_TEMPLATE_H
+
+#include <cstdint>
+
+#include "moteus.h"
+#include "FrameWalker.h"
+
+// A command frame encoded once and patched in place every cycle.
+//
+// Only the commanded velocity (and, when the frame carries it, the
+// feedforward torque) change between motor cycles, so instead of running
+// Controller::MakePosition() and the multiplex encoder for every motor
+// each cycle we keep the encoded frame, remember where those values live
+// and overwrite just their bytes.
+class FrameTemplate
+{
+public:
+    // Takes a frame made by Controller::MakePosition() and locates the
+    // patchable registers.  Returns false if the frame has no velocity
+    // write, in which case the template must not be used.
+    bool build(const mjbots::moteus::CanFdFrame &frame)
+    {
+        using namespace mjbots::moteus;
+
+        frame_ = frame;
+        velocity_ = Slot{};
+        torque_ = Slot{};
+
+        const bool ok = WalkFrame(frame_.data, frame_.size, [&](const FrameField &f) {
+            if (f.kind != FrameField::WRITE) return;
+            if (f.reg == Register::kCommandVelocity) velocity_ = Slot{true, f.offset, f.resolution};
+            if (f.reg == Register::kCommandFeedforwardTorque) torque_ = Slot{true, f.offset, f.resolution};
+        });
+
+        is_valid = ok && velocity_.present;
+        return is_valid;
+    }
+
+    bool valid() const { return is_valid; }
+    bool hasTorque() const { return torque_.present; }
+
+    void setVelocity(double velocity)
+    {
+        uint8_t size = velocity_.offset;
+        mjbots::moteus::WriteCanData out(frame_.data, &size);
+        out.WriteVelocity(velocity, velocity_.resolution);
+    }
+
+    // Ignored when the frame was built without a feedforward torque.
+    void setTorque(double torque)
+    {
+        if (!torque_.present) return;
+        uint8_t size = torque_.offset;
+        mjbots::moteus::WriteCanData out(frame_.data, &size);
+        out.WriteTorque(torque, torque_.resolution);
+    }
+
+    const mjbots::moteus::CanFdFrame &frame() const { return frame_; }
+
+private:
+    struct Slot
+    {
+        bool present = false;
+        uint8_t offset = 0;
+        mjbots::moteus::Resolution resolution = mjbots::moteus::Resolution::kIgnore;
+    };
+
+    mjbots::moteus::CanFdFrame frame_;
+    Slot velocity_;
+    Slot torque_;
+    bool is_valid = false;
+};
+
+#endif // FRAME_TEMPLATE_H
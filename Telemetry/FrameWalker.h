@@ -0,0 +1,83 @@
+#ifndef FRAME_WALKER_H
+#define FRAME_WALKER_H
+
+#include <cstdint>
+
+#include "moteus_multiplex.h"
+
+// Walks the register blocks of an outgoing moteus multiplex frame
+// (writes and reads, as produced by Controller::MakeFoo) and reports
+// every register with its resolution and, for writes, the byte offset of
+// its value.  Used where we need to understand a command frame without
+// going through the full encoder again.
+struct FrameField
+{
+    enum Kind : uint8_t
+    {
+        WRITE,
+        READ,
+    };
+
+    Kind kind;
+    uint16_t reg;
+    mjbots::moteus::Resolution resolution;
+    uint8_t offset;  // byte offset of the value (writes only)
+};
+
+// Calls `on_field(const FrameField&)` for each register in the frame.
+// Returns false if the frame is malformed or contains anything other
+// than write, read and nop blocks.
+template <typename Callback>
+bool WalkFrame(const uint8_t *data, uint8_t size, Callback &&on_field)
+{
+    using namespace mjbots::moteus;
+
+    auto read_varuint = [&](uint8_t &offset, uint16_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 21; shift += 7)
+        {
+            if (offset >= size) return false;
+            const uint8_t byte = data[offset++];
+            value |= static_cast<uint16_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    };
+
+    uint8_t offset = 0;
+    while (offset < size)
+    {
+        const uint8_t cmd = data[offset++];
+        if (cmd == Multiplex::kNop) continue;
+        if (cmd >= 0x20) return false;
+
+        const bool is_write = cmd < Multiplex::kReadBase;
+        const auto res = static_cast<Resolution>((cmd >> 2) & 0x03);
+
+        uint8_t count = cmd & 0x03;
+        if (count == 0)
+        {
+            if (offset >= size) return false;
+            count = data[offset++];
+        }
+
+        uint16_t reg = 0;
+        if (!read_varuint(offset, reg)) return false;
+
+        const uint8_t value_size = MultiplexParser::ResolutionSize(res);
+        for (uint8_t i = 0; i < count; i++)
+        {
+            FrameField field{is_write ? FrameField::WRITE : FrameField::READ,
+                             static_cast<uint16_t>(reg + i), res, offset};
+            if (is_write)
+            {
+                if (offset + value_size > size) return false;
+                offset += value_size;
+            }
+            on_field(field);
+        }
+    }
+    return true;
+}
+
+#endif // FRAME_WALKER_H
@@ -0,0 +1,189 @@
+#include "LinkHealth.h"
+
+#include <algorithm>
+#include <iostream>
+#include <yaml-cpp/yaml.h>
+
+LinkHealth::LinkHealth()
+{
+    initalize_health();
+}
+
+void LinkHealth::initalize_health()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Motor.yaml");
+        YAML::Node health = config["linkHealth"];
+
+        lost_after = health["lostAfter"].as<int>();
+        backoff_cycles = health["backoffCycles"].as<int>();
+        max_backoff_cycles = health["maxBackoffCycles"].as<int>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading link health config: " << e.what() << std::endl;
+        lost_after = 5;
+        backoff_cycles = 5;
+        max_backoff_cycles = 250;
+    }
+
+    lost_after = std::max(lost_after, 1);
+    backoff_cycles = std::max(backoff_cycles, 1);
+    max_backoff_cycles = std::max(max_backoff_cycles, backoff_cycles);
+}
+
+void LinkHealth::addServo(int id)
+{
+    links[id] = Link{};
+}
+
+LinkHealth::Action LinkHealth::action(int id)
+{
+    auto it = links.find(id);
+    if (it == links.end()) return Action::COMMAND;
+    Link &link = it->second;
+
+    switch (link.step)
+    {
+    case Step::NONE:
+    case Step::REARM:
+        link.pending = Action::COMMAND;
+        break;
+    case Step::STOP:
+        link.pending = Action::STOP;
+        break;
+    case Step::QUERY:
+        link.pending = Action::QUERY;
+        break;
+    case Step::WAIT:
+        if (link.wait_cycles > 0)
+        {
+            link.wait_cycles--;
+            link.pending = Action::SKIP;
+        }
+        else
+        {
+            link.step = Step::STOP;
+            link.pending = Action::STOP;
+        }
+        break;
+    }
+
+    if (link.pending != Action::SKIP) link.status.sent++;
+    return link.pending;
+}
+
+void LinkHealth::update(int id, bool replied, int fault, bool in_fault, uint32_t latency_ns)
+{
+    auto it = links.find(id);
+    if (it == links.end()) return;
+    Link &link = it->second;
+    Status &s = link.status;
+
+    if (link.pending == Action::SKIP) return;
+
+    const bool faulted = replied && in_fault;
+    if (replied)
+    {
+        s.replies++;
+        s.consecutive_misses = 0;
+        s.fault = fault;
+        s.latency_ns = latency_ns;
+    }
+    else
+    {
+        s.missed++;
+        s.consecutive_misses++;
+    }
+
+    switch (link.step)
+    {
+    case Step::NONE:
+        if (faulted)
+        {
+            startRecovery(link, State::FAULTED);
+        }
+        else if (s.consecutive_misses >= lost_after)
+        {
+            startRecovery(link, State::LOST);
+        }
+        else
+        {
+            s.state = s.consecutive_misses > 0 ? State::DEGRADED : State::OK;
+        }
+        break;
+    case Step::STOP:
+        if (replied)
+        {
+            link.step = Step::QUERY;
+            s.state = State::RECOVERING;
+        }
+        else
+        {
+            failAttempt(link, State::LOST);
+        }
+        break;
+    case Step::QUERY:
+        if (replied && !faulted)
+        {
+            link.step = Step::REARM;
+        }
+        else
+        {
+            failAttempt(link, replied ? State::FAULTED : State::LOST);
+        }
+        break;
+    case Step::REARM:
+        if (replied && !faulted)
+        {
+            link.step = Step::NONE;
+            s.state = State::OK;
+            s.recoveries++;
+            s.attempts = 0;
+        }
+        else
+        {
+            failAttempt(link, replied ? State::FAULTED : State::LOST);
+        }
+        break;
+    case Step::WAIT:
+        break;
+    }
+}
+
+void LinkHealth::startRecovery(Link &link, State reason)
+{
+    link.status.state = reason;
+    link.step = Step::STOP;
+}
+
+void LinkHealth::failAttempt(Link &link, State reason)
+{
+    // Exponential backoff: backoff, 2 x backoff, 4 x backoff ...
+    link.status.attempts++;
+    const int shift = std::min(link.status.attempts - 1, 16);
+    link.wait_cycles = std::min(max_backoff_cycles, backoff_cycles << shift);
+    link.step = Step::WAIT;
+    link.status.state = reason;
+}
+
+const LinkHealth::Status &LinkHealth::status(int id) const
+{
+    static const Status unknown;
+    auto it = links.find(id);
+    return it == links.end() ? unknown : it->second.status;
+}
+
+const char *LinkHealth::stateToString(State state)
+{
+    switch (state)
+    {
+    case State::OK: return "OK";
+    case State::DEGRADED: return "DEGRADED";
+    case State::LOST: return "LOST";
+    case State::FAULTED: return "FAULTED";
+    case State::RECOVERING: return "RECOVERING";
+    default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef LINK_HEALTH_H
+#define LINK_HEALTH_H
+
+#include <cstdint>
+#include <map>
+
+// CAN link health and recovery per servo.
+//
+// Telemetry asks action() what to send each servo before a cycle and
+// reports the outcome with update() afterwards.  A servo that misses
+// `lostAfter` replies in a row, or reports fault mode, goes through a
+// recovery sequence:
+//
+//   STOP   - stop command, clears a latched fault
+//   QUERY  - query only, confirms the servo is back and fault free
+//   REARM  - the normal command again; a reply puts the link back to OK
+//
+// A step without a reply waits `backoff` cycles (doubling on every
+// failed attempt up to maxBackoffCycles) and starts again from STOP.
+class LinkHealth
+{
+public:
+    enum class State : uint8_t
+    {
+        OK = 0,      // replying normally
+        DEGRADED,    // missed replies, not yet lost
+        LOST,        // lostAfter misses in a row, recovery starts
+        FAULTED,     // servo reported a fault, recovery starts
+        RECOVERING,  // running the recovery sequence
+        NUM_STATES
+    };
+
+    enum class Action : uint8_t
+    {
+        COMMAND,  // normal position command
+        STOP,
+        QUERY,
+        SKIP,     // backing off, send nothing
+    };
+
+    struct Status
+    {
+        State state = State::OK;
+        uint64_t sent = 0;        // frames sent
+        uint64_t replies = 0;
+        uint64_t missed = 0;
+        int consecutive_misses = 0;
+        int fault = 0;            // last fault code reported
+        uint32_t latency_ns = 0;  // reply latency of the servo's bus, 0 if unknown
+        int recoveries = 0;       // completed recoveries
+        int attempts = 0;         // failed recovery attempts since the last success
+    };
+
+    LinkHealth();
+    ~LinkHealth() = default;
+
+    void addServo(int id);
+
+    // What to send `id` this cycle.
+    Action action(int id);
+
+    // Outcome of this cycle for `id`.  `in_fault` (servo in fault mode)
+    // and `fault` (its fault code, for diagnostics) only count on a reply.
+    void update(int id, bool replied, int fault, bool in_fault, uint32_t latency_ns);
+
+    const Status &status(int id) const;
+
+    static const char *stateToString(State state);
+
+private:
+    enum class Step : uint8_t
+    {
+        NONE,
+        STOP,
+        QUERY,
+        REARM,
+        WAIT,
+    };
+
+    struct Link
+    {
+        Status status;
+        Step step = Step::NONE;
+        Action pending = Action::COMMAND;
+        int wait_cycles = 0;
+    };
+
+    int lost_after;
+    int backoff_cycles;
+    int max_backoff_cycles;
+
+    std::map<int, Link> links;
+
+    void initalize_health();
+    void startRecovery(Link &link, State reason);
+    void failAttempt(Link &link, State reason);
+};
+
+#endif // LINK_HEALTH_H
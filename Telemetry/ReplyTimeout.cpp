@@ -0,0 +1,131 @@
+#include "ReplyTimeout.h"
+
+#include <algorithm>
+#include <iostream>
+#include <yaml-cpp/yaml.h>
+
+ReplyTimeoutCalibrator::ReplyTimeoutCalibrator()
+{
+    initalize_timeout();
+}
+
+void ReplyTimeoutCalibrator::initalize_timeout()
+{
+    try
+    {
+        YAML::Node config = YAML::LoadFile("../config/Motor.yaml");
+        YAML::Node timeout = config["replyTimeout"];
+
+        is_enabled = timeout["enabled"].as<bool>();
+        calibration_cycles = timeout["calibrationCycles"].as<int>();
+        window = timeout["window"].as<int>();
+        percentile = timeout["percentile"].as<double>();
+        margin_ns = timeout["marginUs"].as<uint32_t>() * 1000;
+        min_timeout_ns = timeout["minUs"].as<uint32_t>() * 1000;
+        fallback_cycles = timeout["fallbackCycles"].as<int>();
+        recompute_every = timeout["recomputeEvery"].as<int>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error loading reply timeout config: " << e.what() << std::endl;
+        is_enabled = false;
+        calibration_cycles = 200;
+        window = 500;
+        percentile = 99.0;
+        margin_ns = 100000;
+        min_timeout_ns = 150000;
+        fallback_cycles = 100;
+        recompute_every = 50;
+    }
+
+    window = std::max(window, 1);
+    recompute_every = std::max(recompute_every, 1);
+    percentile = std::max(0.0, std::min(100.0, percentile));
+
+    for (auto &bus : samples) bus.resize(window);
+    scratch.resize(window);
+}
+
+void ReplyTimeoutCalibrator::setConservative(const mjbots::pi3hat::Pi3Hat::Input &input)
+{
+    conservative = input;
+    tuned = input;
+}
+
+mjbots::pi3hat::Pi3Hat::Input *ReplyTimeoutCalibrator::input()
+{
+    return (is_calibrated && fallback_remaining == 0) ? &tuned : &conservative;
+}
+
+void ReplyTimeoutCalibrator::update(const int expected[6], const int received[6],
+                                    const mjbots::pi3hat::Pi3Hat::Output &output)
+{
+    cycles++;
+
+    bool missed = false;
+    for (int bus = 1; bus < 6; bus++)
+    {
+        if (expected[bus] == 0) continue;
+        if (received[bus] < expected[bus])
+        {
+            missed = true;
+            continue;
+        }
+        samples[bus][next[bus]] = output.rx_latency_ns[bus];
+        next[bus] = (next[bus] + 1) % samples[bus].size();
+        count[bus] = std::min(count[bus] + 1, samples[bus].size());
+    }
+
+    if (missed)
+    {
+        miss_count++;
+        if (is_calibrated && fallback_remaining == 0)
+        {
+            std::cerr << "Reply timeout: missed reply, using conservative waits for "
+                      << fallback_cycles << " cycles" << std::endl;
+        }
+        fallback_remaining = fallback_cycles;
+    }
+    else if (fallback_remaining > 0)
+    {
+        fallback_remaining--;
+    }
+
+    if (cycles >= static_cast<uint64_t>(calibration_cycles) &&
+        (!is_calibrated || cycles % recompute_every == 0))
+    {
+        recompute();
+    }
+}
+
+void ReplyTimeoutCalibrator::recompute()
+{
+    uint32_t worst = 0;
+    bool any = false;
+    for (int bus = 1; bus < 6; bus++)
+    {
+        if (count[bus] == 0) continue;
+
+        std::copy(samples[bus].begin(), samples[bus].begin() + count[bus], scratch.begin());
+        const size_t rank = std::min(count[bus] - 1,
+                                     static_cast<size_t>(percentile / 100.0 * count[bus]));
+        std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.begin() + count[bus]);
+        bus_percentile[bus] = scratch[rank];
+        worst = std::max(worst, bus_percentile[bus]);
+        any = true;
+    }
+    if (!any) return;
+
+    // The timeout covers the slowest bus, the calculated wire time
+    // already sits under rx_baseline so only the margin is added there.
+    tuned.timeout_ns = std::max(min_timeout_ns, worst + margin_ns);
+    tuned.rx_baseline_wait_ns = margin_ns;
+    tuned.min_tx_wait_ns = std::min(conservative.min_tx_wait_ns, margin_ns);
+
+    if (!is_calibrated)
+    {
+        std::cout << "Reply timeout calibrated: p" << percentile << " " << worst / 1000
+                  << " us, timeout " << tuned.timeout_ns / 1000 << " us\n";
+    }
+    is_calibrated = true;
+}
@@ -0,0 +1,73 @@
+#ifndef REPLY_TIMEOUT_H
+#define REPLY_TIMEOUT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pi3hat.h"
+
+// Tunes the pi3hat CAN reply waits from measured reply latency.
+//
+// The pi3hat defaults (1 ms rx baseline, 200 us minimum wait) are sized
+// for any host.  This keeps a rolling window of the per-bus reply latency
+// reported in Pi3Hat::Output and, once calibrationCycles cycles have been
+// seen, waits for the configured percentile plus a margin instead.
+//
+// A missed reply means the window may be too short, so the conservative
+// values come back for fallbackCycles cycles; the samples taken then are
+// not cut off by the short timeout and feed the next estimate.
+class ReplyTimeoutCalibrator
+{
+public:
+    ReplyTimeoutCalibrator();
+    ~ReplyTimeoutCalibrator() = default;
+
+    bool enabled() const { return is_enabled; }
+    bool calibrated() const { return is_calibrated; }
+    bool fallingBack() const { return fallback_remaining > 0; }
+
+    // Values used before calibration and after a miss.
+    void setConservative(const mjbots::pi3hat::Pi3Hat::Input &input);
+
+    // Input override for the next cycle.
+    mjbots::pi3hat::Pi3Hat::Input *input();
+
+    // `expected[bus]` replies were asked for, `received[bus]` came back
+    // (buses 1 to 5, index 0 unused).
+    void update(const int expected[6], const int received[6],
+                const mjbots::pi3hat::Pi3Hat::Output &output);
+
+    uint32_t timeoutNs() const { return tuned.timeout_ns; }
+    uint32_t busPercentileNs(int bus) const { return bus_percentile[bus]; }
+    uint64_t misses() const { return miss_count; }
+
+private:
+    bool is_enabled;
+    int calibration_cycles;
+    int window;
+    double percentile;      // 0 - 100
+    uint32_t margin_ns;
+    uint32_t min_timeout_ns;
+    int fallback_cycles;
+    int recompute_every;
+
+    mjbots::pi3hat::Pi3Hat::Input conservative;
+    mjbots::pi3hat::Pi3Hat::Input tuned;
+
+    // Ring buffer of latency samples per bus
+    std::vector<uint32_t> samples[6];
+    size_t next[6] = {};
+    size_t count[6] = {};
+    std::vector<uint32_t> scratch;
+    uint32_t bus_percentile[6] = {};
+
+    bool is_calibrated = false;
+    int fallback_remaining = 0;
+    uint64_t cycles = 0;
+    uint64_t miss_count = 0;
+
+    void initalize_timeout();
+    void recompute();
+};
+
+#endif // REPLY_TIMEOUT_H
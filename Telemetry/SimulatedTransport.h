@@ -0,0 +1,250 @@
+#ifndef SIMULATED_TRANSPORT_H
+#define SIMULATED_TRANSPORT_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "moteus.h"
+#include "FrameWalker.h"
+
+// Software stand-in for a set of moteus controllers.
+//
+// MoteusEmulator decodes the command frames produced by
+// moteus::Controller (stop and position mode), runs a first-order model
+// of each wheel and answers the query part of the frame with the same
+// register layout a real controller would use.  SimulatedTransport
+// wraps it as a moteus::Transport so Telemetry, the controllers and the
+// safety code can be exercised on any Linux box without a pi3hat.
+//
+// Cycles are deterministic: each Cycle() advances the model by exactly
+// `step_s`, independent of wall clock time.
+class MoteusEmulator
+{
+public:
+    struct Options
+    {
+        double step_s = 0.02;           // model time per cycle
+        double time_constant_s = 0.05;  // velocity loop response
+        double voltage = 24.0;          // bus voltage reported
+        double temperature = 30.0;      // board temperature reported
+        double amps_per_accel = 0.05;   // A per rev/s^2
+        double amps_per_velocity = 0.02; // A per rev/s (friction)
+
+        Options() {}
+    };
+
+    struct Servo
+    {
+        int bus = 1;
+        mjbots::moteus::Mode mode = mjbots::moteus::Mode::kStopped;
+        double command_velocity = 0.0;
+        double position = 0.0;
+        double velocity = 0.0;
+        double torque = 0.0;
+        double q_current = 0.0;
+        double voltage = 0.0;
+        double temperature = 0.0;
+        int fault = 0;
+
+        // Fraction of the commanded speed the wheel reaches, use to model
+        // slip, battery sag or mechanical asymmetry.
+        double gain = 1.0;
+        // When false the servo never replies (unplugged or dead).
+        bool online = true;
+    };
+
+    explicit MoteusEmulator(const Options &options = Options()) : options_(options) {}
+
+    void addServo(int id, int bus)
+    {
+        Servo servo;
+        servo.bus = bus;
+        servo.voltage = options_.voltage;
+        servo.temperature = options_.temperature;
+        servos_[id] = servo;
+    }
+
+    Servo *servo(int id)
+    {
+        auto it = servos_.find(id);
+        return it == servos_.end() ? nullptr : &it->second;
+    }
+
+    const std::map<int, Servo> &servos() const { return servos_; }
+
+    // Advance every servo by one model step.
+    void step()
+    {
+        const double dt = options_.step_s;
+        const double alpha = dt / (options_.time_constant_s + dt);
+        for (auto &pair : servos_)
+        {
+            Servo &s = pair.second;
+            const bool driving = s.mode == mjbots::moteus::Mode::kPosition;
+            const double target = driving ? s.command_velocity * s.gain : 0.0;
+            const double previous = s.velocity;
+
+            s.velocity += alpha * (target - s.velocity);
+            s.position += s.velocity * dt;
+            s.q_current = driving ?
+                options_.amps_per_accel * (s.velocity - previous) / dt +
+                options_.amps_per_velocity * s.velocity : 0.0;
+            s.torque = s.q_current * 0.1;
+        }
+    }
+
+    // Apply one command frame; fills `reply` and returns true if the
+    // addressed servo exists and a reply was requested.
+    bool handle(const mjbots::moteus::CanFdFrame &frame,
+                mjbots::moteus::CanFdFrame *reply)
+    {
+        using namespace mjbots::moteus;
+
+        const int id = frame.arbitration_id & 0x7f;
+        const int source = (frame.arbitration_id >> 8) & 0x7f;
+        auto it = servos_.find(id);
+        if (it == servos_.end() || !it->second.online) return false;
+        Servo &s = it->second;
+
+        FrameField reads[64];
+        int read_count = 0;
+
+        const bool ok = WalkFrame(frame.data, frame.size, [&](const FrameField &f) {
+            if (f.kind == FrameField::READ)
+            {
+                if (read_count < 64) reads[read_count++] = f;
+                return;
+            }
+            MultiplexParser value(&frame.data[f.offset], frame.size - f.offset);
+            switch (f.reg)
+            {
+            case Register::kMode:
+                s.mode = static_cast<Mode>(value.ReadInt(f.resolution));
+                if (s.mode == Mode::kStopped) s.fault = 0;
+                break;
+            case Register::kCommandVelocity:
+                s.command_velocity = value.ReadVelocity(f.resolution);
+                if (std::isnan(s.command_velocity)) s.command_velocity = 0.0;
+                break;
+            default:
+                break;
+            }
+        });
+        if (!ok) return false;
+
+        const bool reply_required = (frame.arbitration_id & 0x8000) != 0;
+        if (!reply_required || reply == nullptr) return false;
+
+        *reply = CanFdFrame{};
+        reply->bus = frame.bus != 0 ? frame.bus : s.bus;
+        reply->source = id;
+        reply->destination = source;
+        reply->arbitration_id = (id << 8) | source;
+
+        WriteCanData out(reply->data, &reply->size);
+        int i = 0;
+        while (i < read_count)
+        {
+            // Group consecutive registers of one resolution like moteus does.
+            int n = 1;
+            while (i + n < read_count &&
+                   reads[i + n].resolution == reads[i].resolution &&
+                   reads[i + n].reg == reads[i].reg + n)
+            {
+                n++;
+            }
+            const int8_t base = Multiplex::kReplyBase |
+                                (static_cast<int8_t>(reads[i].resolution) << 2);
+            if (n <= 3)
+            {
+                out.Write<int8_t>(base | n);
+            }
+            else
+            {
+                out.Write<int8_t>(base);
+                out.Write<int8_t>(n);
+            }
+            out.WriteVaruint(reads[i].reg);
+            for (int k = 0; k < n; k++)
+            {
+                writeRegister(out, s, reads[i + k].reg, reads[i + k].resolution);
+            }
+            i += n;
+        }
+        return true;
+    }
+
+private:
+    static void writeRegister(mjbots::moteus::WriteCanData &out, const Servo &s,
+                              uint16_t reg, mjbots::moteus::Resolution res)
+    {
+        using namespace mjbots::moteus;
+        switch (reg)
+        {
+        case Register::kMode: out.WriteInt(static_cast<int>(s.mode), res); break;
+        case Register::kPosition: out.WritePosition(s.position, res); break;
+        case Register::kVelocity: out.WriteVelocity(s.velocity, res); break;
+        case Register::kTorque: out.WriteTorque(s.torque, res); break;
+        case Register::kQCurrent: out.WriteCurrent(s.q_current, res); break;
+        case Register::kDCurrent: out.WriteCurrent(0.0, res); break;
+        case Register::kVoltage: out.WriteVoltage(s.voltage, res); break;
+        case Register::kTemperature: out.WriteTemperature(s.temperature, res); break;
+        case Register::kMotorTemperature: out.WriteTemperature(s.temperature, res); break;
+        case Register::kFault: out.WriteInt(s.fault, res); break;
+        default: out.WriteInt(0, res); break;
+        }
+    }
+
+    Options options_;
+    std::map<int, Servo> servos_;
+};
+
+class SimulatedTransport : public mjbots::moteus::Transport
+{
+public:
+    using CanFdFrame = mjbots::moteus::CanFdFrame;
+
+    SimulatedTransport(const std::map<int, int> &servo_map,
+                       const MoteusEmulator::Options &options = MoteusEmulator::Options())
+        : emulator_(options)
+    {
+        for (const auto &p : servo_map)
+        {
+            emulator_.addServo(p.first, p.second);
+        }
+    }
+
+    virtual void Cycle(const CanFdFrame *frames,
+                       size_t size,
+                       std::vector<CanFdFrame> *replies,
+                       mjbots::moteus::CompletionCallback completed_callback) override
+    {
+        emulator_.step();
+        if (replies) replies->clear();
+
+        CanFdFrame reply;
+        for (size_t i = 0; i < size; i++)
+        {
+            if (emulator_.handle(frames[i], &reply) && replies)
+            {
+                replies->push_back(reply);
+            }
+        }
+        completed_callback(0);
+    }
+
+    virtual void Post(std::function<void()> callback) override
+    {
+        callback();
+    }
+
+    MoteusEmulator &emulator() { return emulator_; }
+
+private:
+    MoteusEmulator emulator_;
+};
+
+#endif // SIMULATED_TRANSPORT_H
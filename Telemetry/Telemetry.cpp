@@ -1,16 +1,92 @@
 #include "Telemetry.h"
 #include <yaml-cpp/yaml.h>
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include "FixedReplyParser.h"
+#include "BusDiscovery.h"
+#include "SimulatedTransport.h"
+
+namespace
+{
+using mjbots::moteus::Register;
+using mjbots::moteus::Resolution;
+
+// Reply layouts of the shipped Motor.yaml query profiles.  A profile
+// edited to anything else is decoded by Query::Parse().
+using FastReply = FixedReplyParser<
+    ReplyBlock<Register::kMode, Resolution::kInt8>,
+    ReplyBlock<Register::kVelocity, Resolution::kFloat>,
+    ReplyBlock<Register::kQCurrent, Resolution::kInt16>,
+    ReplyBlock<Register::kVoltage, Resolution::kInt8, 3>>;
+
+using FullReply = FixedReplyParser<
+    ReplyBlock<Register::kMode, Resolution::kInt8>,
+    ReplyBlock<Register::kPosition, Resolution::kFloat, 3>,
+    ReplyBlock<Register::kQCurrent, Resolution::kInt16>,
+    ReplyBlock<Register::kVoltage, Resolution::kInt8, 3>>;
+
+mjbots::moteus::Resolution parseResolution(const YAML::Node& node)
+{
+    using mjbots::moteus::Resolution;
+    if (!node) return Resolution::kIgnore;
+
+    const std::string name = node.as<std::string>();
+    if (name == "ignore") return Resolution::kIgnore;
+    if (name == "int8") return Resolution::kInt8;
+    if (name == "int16") return Resolution::kInt16;
+    if (name == "int32") return Resolution::kInt32;
+    if (name == "float") return Resolution::kFloat;
+    throw std::runtime_error("unknown resolution '" + name + "'");
+}
+
+mjbots::moteus::Query::Format parseQueryFormat(const YAML::Node& profile)
+{
+    mjbots::moteus::Query::Format format;
+    format.mode = parseResolution(profile["mode"]);
+    format.position = parseResolution(profile["position"]);
+    format.velocity = parseResolution(profile["velocity"]);
+    format.torque = parseResolution(profile["torque"]);
+    format.q_current = parseResolution(profile["qCurrent"]);
+    format.d_current = parseResolution(profile["dCurrent"]);
+    format.motor_temperature = parseResolution(profile["motorTemperature"]);
+    format.voltage = parseResolution(profile["voltage"]);
+    format.temperature = parseResolution(profile["temperature"]);
+    format.fault = parseResolution(profile["fault"]);
+
+    // The fault handling in RobotFramework depends on the mode
+    if (format.mode == mjbots::moteus::Resolution::kIgnore)
+    {
+        format.mode = mjbots::moteus::Resolution::kInt8;
+    }
+    return format;
+}
+}
 
 Telemetry::Telemetry()
 {
     // Transport configuration for Pi3Hat
     mjbots::pi3hat::Pi3HatMoteusTransport::Options toptions;
     std::map<int, int> servo_map = YAML_Load_MotorMap("../config/Motor.yaml");
-    toptions.servo_map = servo_map;
+    YAML_Load_Imu("../config/Motor.yaml", toptions);
+    YAML_Load_CanWait("../config/Motor.yaml", toptions);
+    YAML_Load_QueryProfiles("../config/Motor.yaml");
+
+    transport = YAML_Load_Transport("../config/Motor.yaml", servo_map);
+    if (!transport)
+    {
+        // Check the map against the buses before anything is sent (BUG-ID-1)
+        BusDiscovery discovery;
+        servo_map = discovery.resolve(servo_map, toptions);
+        missing_motors = discovery.missing();
+        toptions.servo_map = servo_map;
+        checkBusBalance(servo_map);
+        reply_timeout.setConservative(toptions.default_input);
 
-    // A shared transport instance used for the Cycle method
-    transport = std::make_shared<mjbots::pi3hat::Pi3HatMoteusTransport>(toptions);
+        // A shared transport instance used for the Cycle method
+        pi3hat_transport = std::make_shared<mjbots::pi3hat::Pi3HatMoteusTransport>(toptions);
+        transport = pi3hat_transport;
+    }
 
     // Create controllers for each motor ID / bus pair, using the shared transport
     for (const auto &p : servo_map)
@@ -20,8 +96,11 @@ Telemetry::Telemetry()
         opts.bus = p.second;
         opts.transport = transport;
         controllers[opts.id] = std::make_shared<mjbots::moteus::Controller>(opts);
+        link_health.addServo(opts.id);
     }
 
+    initalize_templates();
+
     // Issue a stop command to all controllers (clear faults before starting)
     for (const auto &pair : controllers)
     {
@@ -35,19 +114,85 @@ std::map<int, MotorTelemetry> Telemetry::cycle(const std::map<int, double> &velo
     std::vector<mjbots::moteus::CanFdFrame> command_frames;
     command_frames.reserve(controllers.size());
 
+    // Cheap reply every cycle, the full one every full_every cycles
+    const bool full = (cycle_count++ % full_every) == 0;
+    const mjbots::moteus::Query::Format &query = full ? full_query : fast_query;
+
     for (const auto &pair : controllers)
     {
+        // Servos recovering from a lost link or fault get the recovery
+        // step instead of a command
+        switch (link_health.action(pair.first))
+        {
+        case LinkHealth::Action::SKIP:
+            continue;
+        case LinkHealth::Action::STOP:
+            command_frames.push_back(pair.second->MakeStop(&query));
+            continue;
+        case LinkHealth::Action::QUERY:
+            command_frames.push_back(pair.second->MakeQuery(&query));
+            continue;
+        case LinkHealth::Action::COMMAND:
+            break;
+        }
+
+        auto held = held_stopped.find(pair.first);
+        if (held != held_stopped.end() && held->second)
+        {
+            command_frames.push_back(pair.second->MakeStop(&query));
+            continue;
+        }
+
+        auto it = velocity_map.find(pair.first);
+        const double velocity = (it != velocity_map.end()) ? it->second : 0.0;
+
+        // Patch the velocity into the pre-encoded frame
+        CommandTemplates &templates = command_templates[pair.first];
+        FrameTemplate &frame = full ? templates.full : templates.fast;
+        if (frame.valid())
+        {
+            frame.setVelocity(velocity);
+            command_frames.push_back(frame.frame());
+            continue;
+        }
+
         mjbots::moteus::PositionMode::Command position_command;
         position_command.position = std::numeric_limits<double>::quiet_NaN();
-        auto it = velocity_map.find(pair.first);
-        position_command.velocity = (it != velocity_map.end()) ? it->second : 0.0;
-        command_frames.push_back(pair.second->MakePosition(position_command));
+        position_command.velocity = velocity;
+        command_frames.push_back(pair.second->MakePosition(position_command, nullptr, &query));
     }
 
     // Send all commands in one BlockingCycle and collect replies
     std::vector<mjbots::moteus::CanFdFrame> replies;
 
-    if (!command_frames.empty())
+    const bool full_cycle = pi3hat_transport && (imu_enabled || reply_timeout.enabled());
+    if (full_cycle)
+    {
+        // Read the attitude in the same SPI transaction as the CAN traffic
+        mjbots::moteus::BlockingCallback cbk;
+        pi3hat_transport->Cycle(command_frames.data(), command_frames.size(), &replies,
+                         imu_enabled ? &attitude : nullptr, &pi3hat_output,
+                         reply_timeout.enabled() ? reply_timeout.input() : nullptr,
+                         cbk.callback());
+        cbk.Wait();
+        if (imu_enabled) updateImu();
+
+        if (reply_timeout.enabled())
+        {
+            int expected[6] = {};
+            int received[6] = {};
+            for (const auto &frame : command_frames)
+            {
+                if (frame.reply_required && frame.bus > 0 && frame.bus < 6) expected[frame.bus]++;
+            }
+            for (const auto &frame : replies)
+            {
+                if (frame.bus > 0 && frame.bus < 6) received[frame.bus]++;
+            }
+            reply_timeout.update(expected, received, pi3hat_output);
+        }
+    }
+    else if (!command_frames.empty())
     {
         transport->BlockingCycle(command_frames.data(), command_frames.size(), &replies);
     }
@@ -56,20 +201,59 @@ std::map<int, MotorTelemetry> Telemetry::cycle(const std::map<int, double> &velo
     std::map<int, MotorTelemetry> servo_data;
     for (const auto &frame : replies)
     {
-        auto parsed = mjbots::moteus::Query::Parse(frame.data, frame.size);
+        mjbots::moteus::Query::Result parsed;
+        const bool fixed = full ?
+            full_fixed && FullReply::parse(frame.data, frame.size, &parsed) :
+            fast_fixed && FastReply::parse(frame.data, frame.size, &parsed);
+        if (!fixed)
+        {
+            parsed = mjbots::moteus::Query::Parse(frame.data, frame.size);
+        }
+
+        // Registers this profile did not ask for keep their last value
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        auto last = last_data.find(frame.source);
         MotorTelemetry mt;
-        mt.temperature = parsed.temperature;
-        mt.voltage = parsed.voltage;
-        mt.velocity = parsed.velocity;
-        mt.current = parsed.q_current;
+        if (last != last_data.end())
+        {
+            mt = last->second;
+        }
+        else
+        {
+            mt.temperature = nan;
+            mt.voltage = nan;
+            mt.velocity = nan;
+            mt.current = nan;
+            mt.fault = 0;
+        }
+        if (query.temperature != Resolution::kIgnore) mt.temperature = parsed.temperature;
+        if (query.voltage != Resolution::kIgnore) mt.voltage = parsed.voltage;
+        if (query.velocity != Resolution::kIgnore) mt.velocity = parsed.velocity;
+        if (query.q_current != Resolution::kIgnore) mt.current = parsed.q_current;
+        if (query.fault != Resolution::kIgnore) mt.fault = parsed.fault;
         // mt.position = parsed.position;
         mt.mode = static_cast<int>(parsed.mode);
         servo_data[frame.source] = mt;
+        last_data[frame.source] = mt;
 
         // std::cout<< "Current is: " << parsed.q_current<< "\n"; 
     }
     // std::cout << servo_data << "\n";
 
+    // Link health: replies, faults and latency of each servo's bus
+    for (const auto &pair : controllers)
+    {
+        auto it = servo_data.find(pair.first);
+        const bool replied = it != servo_data.end();
+        const int bus = pair.second->options().bus;
+        const uint32_t latency =
+            (full_cycle && bus > 0 && bus < 6) ? pi3hat_output.rx_latency_ns[bus] : 0;
+        link_health.update(pair.first, replied,
+                           replied ? it->second.fault : 0,
+                           replied && it->second.mode == static_cast<int>(mjbots::moteus::Mode::kFault),
+                           latency);
+    }
+
     return servo_data;
 }
 
@@ -93,4 +277,227 @@ std::map<int,int> Telemetry::YAML_Load_MotorMap(const std::string& path) {
     }
 
     return motor_map;
+}
+
+void Telemetry::checkBusBalance(const std::map<int, int> &servo_map)
+{
+    // Every motor costs about the same wire time per cycle, so the busiest
+    // bus sets the cycle time.  The pi3hat sends on all buses at once.
+    // Spare buses are taken alternating between its processors (1-2, 3-4, 5).
+    static const int kBusOrder[] = {1, 3, 2, 4, 5};
+
+    int per_bus[6] = {};
+    for (const auto &p : servo_map)
+    {
+        if (p.second > 0 && p.second < 6) per_bus[p.second]++;
+    }
+    const int busiest = *std::max_element(per_bus + 1, per_bus + 6);
+    const int best = static_cast<int>((servo_map.size() + 4) / 5);
+    if (busiest <= best) return;
+
+    // Keep motors where they are up to the balanced count, move the rest
+    std::map<int, int> suggested;
+    std::vector<int> moved;
+    int load[6] = {};
+    for (const auto &p : servo_map)
+    {
+        if (p.second > 0 && p.second < 6 && load[p.second] < best)
+        {
+            suggested[p.first] = p.second;
+            load[p.second]++;
+        }
+        else
+        {
+            moved.push_back(p.first);
+        }
+    }
+    for (int id : moved)
+    {
+        int bus = kBusOrder[0];
+        for (int candidate : kBusOrder)
+        {
+            if (load[candidate] < load[bus]) bus = candidate;
+        }
+        suggested[id] = bus;
+        load[bus]++;
+    }
+
+    std::cerr << "Motor bus map unbalanced: " << busiest << " motors on one bus, "
+              << best << " would do. Suggested motorMap:\n";
+    for (const auto &p : suggested)
+    {
+        std::cerr << "  " << p.first << ": " << p.second << "\n";
+    }
+}
+
+std::shared_ptr<mjbots::moteus::Transport> Telemetry::YAML_Load_Transport(
+    const std::string& path, const std::map<int, int>& servo_map)
+{
+    YAML::Node section;
+    try {
+        YAML::Node config = YAML::LoadFile(path);
+        section = config["transport"];
+        if (section) transport_type = section["type"].as<std::string>();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading transport config: " << e.what() << std::endl;
+        transport_type = "pi3hat";
+    }
+
+    // The pi3hat transport is built by the caller, after bus discovery
+    if (transport_type == "pi3hat") return nullptr;
+
+    // The IMU and the reply wait tuning live on the pi3hat
+    if (imu_enabled)
+    {
+        std::cerr << "IMU needs the pi3hat transport, disabled for " << transport_type << std::endl;
+        imu_enabled = false;
+    }
+
+    if (transport_type == "socketcan")
+    {
+        // One interface carries every motor, the motorMap buses are ignored
+        mjbots::moteus::Socketcan::Options options;
+        try {
+            YAML::Node socketcan = section["socketcan"];
+            options.ifname = socketcan["iface"].as<std::string>();
+            options.disable_brs = socketcan["disableBrs"].as<bool>();
+            const uint32_t reply_wait_ns = socketcan["replyWaitUs"].as<uint32_t>() * 1000;
+            options.min_ok_wait_ns = reply_wait_ns;
+            options.min_rcv_wait_ns = reply_wait_ns;
+            options.rx_extra_wait_ns = reply_wait_ns;
+            options.final_wait_ns = socketcan["flushWaitUs"].as<uint32_t>() * 1000;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error loading socketcan config: " << e.what() << std::endl;
+            options = mjbots::moteus::Socketcan::Options();
+            options.ifname = "can0";
+        }
+        std::cout << "Motor transport: socketcan on " << options.ifname << std::endl;
+        return std::make_shared<mjbots::moteus::Socketcan>(options);
+    }
+
+    if (transport_type == "simulated")
+    {
+        MoteusEmulator::Options options;
+        try {
+            options.step_s = section["simulated"]["stepS"].as<double>();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error loading simulated transport config: " << e.what() << std::endl;
+        }
+        std::cout << "Motor transport: simulated" << std::endl;
+        return std::make_shared<SimulatedTransport>(servo_map, options);
+    }
+
+    std::cerr << "Unknown transport type " << transport_type << ", using pi3hat" << std::endl;
+    transport_type = "pi3hat";
+    return nullptr;
+}
+
+void Telemetry::YAML_Load_Imu(const std::string& path,
+                              mjbots::pi3hat::Pi3HatMoteusTransport::Options& toptions)
+{
+    try {
+        YAML::Node config = YAML::LoadFile(path);
+        YAML::Node imu = config["imu"];
+        if (!imu) return;
+
+        imu_enabled = imu["enabled"].as<bool>();
+        toptions.attitude_rate_hz = imu["attitudeRateHz"].as<uint32_t>();
+        toptions.mounting_deg.yaw = imu["mountingYaw"].as<double>();
+        toptions.mounting_deg.pitch = imu["mountingPitch"].as<double>();
+        toptions.mounting_deg.roll = imu["mountingRoll"].as<double>();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading IMU config: " << e.what() << std::endl;
+        imu_enabled = false;
+    }
+}
+
+void Telemetry::YAML_Load_QueryProfiles(const std::string& path)
+{
+    try {
+        YAML::Node config = YAML::LoadFile(path);
+        YAML::Node profiles = config["queryProfile"];
+        if (!profiles) throw std::runtime_error("no queryProfile block");
+
+        fast_query = parseQueryFormat(profiles["fast"]);
+        full_query = parseQueryFormat(profiles["full"]);
+        full_every = profiles["fullEvery"].as<int>();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading query profile config: " << e.what() << std::endl;
+        // moteus defaults, plus the current the safety checks rely on
+        fast_query = mjbots::moteus::Query::Format();
+        fast_query.q_current = mjbots::moteus::Resolution::kInt16;
+        full_query = fast_query;
+        full_every = 10;
+    }
+
+    if (full_every < 1) full_every = 1;
+
+    fast_fixed = FastReply::matches(fast_query);
+    full_fixed = FullReply::matches(full_query);
+}
+
+void Telemetry::initalize_templates()
+{
+    // Encode the position command once per motor and profile, cycle()
+    // only rewrites the velocity bytes.  A template that cannot be
+    // parsed stays invalid and cycle() falls back to MakePosition().
+    mjbots::moteus::PositionMode::Command position_command;
+    position_command.position = std::numeric_limits<double>::quiet_NaN();
+    position_command.velocity = 0.0;
+
+    for (const auto &pair : controllers)
+    {
+        CommandTemplates &templates = command_templates[pair.first];
+        if (!templates.fast.build(pair.second->MakePosition(position_command, nullptr, &fast_query)) ||
+            !templates.full.build(pair.second->MakePosition(position_command, nullptr, &full_query)))
+        {
+            std::cerr << "Motor " << pair.first
+                      << ": command template unavailable, encoding every cycle" << std::endl;
+        }
+    }
+}
+
+void Telemetry::YAML_Load_CanWait(const std::string& path,
+                                  mjbots::pi3hat::Pi3HatMoteusTransport::Options& toptions)
+{
+    using WaitStrategy = mjbots::pi3hat::Pi3Hat::Configuration::WaitStrategy;
+    try {
+        YAML::Node config = YAML::LoadFile(path);
+        YAML::Node wait = config["canWait"];
+        if (!wait) return;
+
+        const std::string strategy = wait["strategy"].as<std::string>();
+        if (strategy == "spin") toptions.wait_strategy = WaitStrategy::kSpin;
+        else if (strategy == "spinThenSleep") toptions.wait_strategy = WaitStrategy::kSpinThenSleep;
+        else if (strategy == "sleepThenSpin") toptions.wait_strategy = WaitStrategy::kSleepThenSpin;
+        else throw std::runtime_error("unknown strategy '" + strategy + "'");
+
+        toptions.wait_spin_ns = wait["spinUs"].as<uint32_t>() * 1000;
+        toptions.wait_sleep_first_ns = wait["sleepFirstUs"].as<uint32_t>() * 1000;
+        toptions.wait_poll_sleep_ns = wait["pollSleepUs"].as<uint32_t>() * 1000;
+
+        // Processor counters for the CAN performance log, read between cycles
+        device_performance = wait["devicePerformance"].as<bool>(false);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading CAN wait config: " << e.what() << std::endl;
+        toptions.wait_strategy = WaitStrategy::kSpin;
+    }
+}
+
+void Telemetry::updateImu()
+{
+    if (!pi3hat_output.attitude_present) return;
+
+    // Yaw from the attitude quaternion (z-y-x convention)
+    const auto &q = attitude.attitude;
+    imu_state.yaw = std::atan2(2.0 * (q.w * q.z + q.x * q.y),
+                               1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+    imu_state.yaw_rate = attitude.rate_dps.z * (M_PI / 180.0);
+    imu_state.present = true;
 }
\ No newline at end of file
@@ -10,9 +10,13 @@
 #include <chrono>
 #include <thread>
 #include <limits>
+#include <string>
 
 #include "moteus.h"
 #include "pi3hat_moteus_transport.h"
+#include "FrameTemplate.h"
+#include "ReplyTimeout.h"
+#include "LinkHealth.h"
 
 struct MotorTelemetry
 {
@@ -22,6 +26,16 @@ struct MotorTelemetry
     double current;
     // double position;
     int mode;
+    int fault;          // moteus fault code, 0 when healthy
+};
+
+// Robot heading from the pi3hat IMU, refreshed in the same SPI cycle as
+// the CAN traffic when imu.enabled is set in Motor.yaml.
+struct ImuTelemetry
+{
+    bool present = false;     // true once an attitude has been read
+    double yaw = 0.0;         // rad, wrapped to [-pi, pi]
+    double yaw_rate = 0.0;    // rad/s about the body z axis
 };
 
 class Telemetry
@@ -35,10 +49,84 @@ public:
     // controllers keyed by CAN ID
     std::map<int, std::shared_ptr<mjbots::moteus::Controller>> controllers;
 
-    // shared transport instance used for BlockingCycle
-    std::shared_ptr<mjbots::pi3hat::Pi3HatMoteusTransport> transport;
+    // shared transport instance used for BlockingCycle, selected by
+    // transport.type in Motor.yaml
+    std::shared_ptr<mjbots::moteus::Transport> transport;
+    // the same transport when it is the pi3hat, null otherwise
+    std::shared_ptr<mjbots::pi3hat::Pi3HatMoteusTransport> pi3hat_transport;
+
+    // pi3hat, socketcan or simulated
+    const std::string& transportType() const { return transport_type; }
+
+    static std::map<int,int> YAML_Load_MotorMap(const std::string& path);
+
+    // Latest IMU state, only updated when the IMU is enabled
+    const ImuTelemetry& imu() const { return imu_state; }
+    bool imuEnabled() const { return imu_enabled; }
+
+    // Reply counters, fault codes and recovery state per motor
+    const LinkHealth& linkHealth() const { return link_health; }
+
+    // Read the pi3hat processor counters for the CAN performance log
+    // (Motor.yaml canWait.devicePerformance)
+    bool devicePerformanceEnabled() const { return device_performance && pi3hat_transport != nullptr; }
+
+    // Configured motors that did not answer bus discovery at startup
+    const std::vector<int>& missingMotors() const { return missing_motors; }
+
+    // Send `id` stop instead of its command (still queried) until cleared
+    void holdStopped(int id, bool stop) { held_stopped[id] = stop; }
+
+    // Reply layout requested every cycle and every fullEvery-th cycle
+    const mjbots::moteus::Query::Format& fastQuery() const { return fast_query; }
+    const mjbots::moteus::Query::Format& fullQuery() const { return full_query; }
+
+private:
+    std::string transport_type = "pi3hat";
+    bool imu_enabled = false;
+    bool device_performance = false;
+    mjbots::pi3hat::Attitude attitude;
+    mjbots::pi3hat::Pi3Hat::Output pi3hat_output;
+    ImuTelemetry imu_state;
+
+    // Query profiles from Motor.yaml queryProfile, built once
+    mjbots::moteus::Query::Format fast_query;
+    mjbots::moteus::Query::Format full_query;
+    int full_every = 10;
+    uint64_t cycle_count = 0;
+
+    // Reply waits tuned from measured latency (Motor.yaml replyTimeout)
+    ReplyTimeoutCalibrator reply_timeout;
+    LinkHealth link_health;
+    std::vector<int> missing_motors;
+    // Profile matches the compiled reply layout (FixedReplyParser)
+    bool fast_fixed = false;
+    bool full_fixed = false;
+    // Motors held stopped by the caller (MotorSupervisor)
+    std::map<int, bool> held_stopped;
+    // Last reply per motor, holds the registers the fast profile skips
+    std::map<int, MotorTelemetry> last_data;
+
+    // Pre-encoded position command per motor, one per query profile
+    struct CommandTemplates
+    {
+        FrameTemplate fast;
+        FrameTemplate full;
+    };
+    std::map<int, CommandTemplates> command_templates;
+    void initalize_templates();
+
+    // Warn and suggest a motorMap when one bus carries more motors than needed
+    void checkBusBalance(const std::map<int, int> &servo_map);
 
-    std::map<int,int> YAML_Load_MotorMap(const std::string& path);
+    void YAML_Load_Imu(const std::string& path,
+                       mjbots::pi3hat::Pi3HatMoteusTransport::Options& toptions);
+    void YAML_Load_CanWait(const std::string& path,
+                           mjbots::pi3hat::Pi3HatMoteusTransport::Options& toptions);
+    std::shared_ptr<mjbots::moteus::Transport> YAML_Load_Transport(
+        const std::string& path, const std::map<int, int>& servo_map);
+    void updateImu();
+    void YAML_Load_QueryProfiles(const std::string& path);
 };
 
 #endif // TELEMETRY_H
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <fstream>
@@ -107,6 +108,15 @@ int64_t GetNow() {
       static_cast<int64_t>(ts.tv_nsec);
 }
 
+void SleepNs(int64_t ns) {
+  if (ns <= 0) { return; }
+  struct timespec ts = {};
+  ts.tv_sec = ns / 1000000000ll;
+  ts.tv_nsec = ns % 1000000000ll;
+  // Relative sleeps, so CLOCK_MONOTONIC matches the RAW clock in GetNow.
+  while (::clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR);
+}
+
 void BusyWaitUs(int64_t us) {
   // We wait to ensure that setup and hold times are properly
   // enforced.  Allowing data stores and loads to be re-ordered around
@@ -1382,45 +1392,58 @@ class Pi3Hat::Impl {
     std::array<int64_t, 6> receive_ns = { {} };
   };
 
+  // Estimated time for `frame` to go out over SPI and the wire.
+  int64_t FrameSendNs(const CanFrame& frame) const {
+    const int64_t arbitration_bitrate =
+        config_.can[frame.bus - 1].slow_bitrate;
+    const int64_t data_bitrate =
+        config_.can[frame.bus - 1].bitrate_switch ?
+        config_.can[frame.bus - 1].fast_bitrate :
+        config_.can[frame.bus - 1].slow_bitrate;
+
+    const int64_t can_header_size_bits =
+        (frame.id >= 2048 ? 32 : 16) + 8;
+    const int64_t can_data_size_bits =
+        frame.size * 8 + 28;
+    const int64_t tx_spi_bits =
+        (frame.size + 5) * 8;
+    return
+        1000000000 * can_header_size_bits / arbitration_bitrate +
+        1000000000 * can_data_size_bits / data_bitrate +
+        1000000000 * tx_spi_bits / config_.spi_speed_hz;
+  }
+
+  // Estimated time for the reply to `frame` to come back, 0 if none
+  // is expected.
+  int64_t FrameReceiveNs(const CanFrame& frame) const {
+    if (!frame.expect_reply) { return 0; }
+
+    const int64_t arbitration_bitrate =
+        config_.can[frame.bus - 1].slow_bitrate;
+    const int64_t data_bitrate =
+        config_.can[frame.bus - 1].bitrate_switch ?
+        config_.can[frame.bus - 1].fast_bitrate :
+        config_.can[frame.bus - 1].slow_bitrate;
+
+    const int64_t rx_header_size_bits = 32;
+    const int64_t rx_data_size_bits =
+        frame.expected_reply_size * 8 + 28;
+    const int64_t rx_spi_bits =
+        (frame.expected_reply_size + 5) * 8;
+    return
+        1000000000 * rx_header_size_bits / arbitration_bitrate +
+        1000000000 * rx_data_size_bits / data_bitrate +
+        1000000000 * rx_spi_bits / config_.spi_speed_hz;
+  }
+
   ExpectedReply CalculateExpectedReply(const Input& input) {
     ExpectedReply result;
 
     for (size_t i = 0; i < input.tx_can.size(); i++) {
       const auto bus = input.tx_can[i].bus;
 
-      const int64_t arbitration_bitrate =
-          config_.can[bus - 1].slow_bitrate;
-      const int64_t data_bitrate =
-          config_.can[bus - 1].bitrate_switch ?
-          config_.can[bus - 1].fast_bitrate :
-          config_.can[bus - 1].slow_bitrate;
-
-      const int64_t can_header_size_bits =
-          (input.tx_can[i].id >= 2048 ? 32 : 16) + 8;
-      const int64_t can_data_size_bits =
-          input.tx_can[i].size * 8 + 28;
-      const int64_t tx_spi_bits =
-          (input.tx_can[i].size + 5) * 8;
-      const int64_t can_send_ns =
-          1000000000 * can_header_size_bits / arbitration_bitrate +
-          1000000000 * can_data_size_bits / data_bitrate +
-          1000000000 * tx_spi_bits / config_.spi_speed_hz;
-
-      result.send_ns[bus] += can_send_ns;
-
-      if (input.tx_can[i].expect_reply) {
-        const int64_t rx_header_size_bits = 32;
-        const int64_t rx_data_size_bits =
-            input.tx_can[i].expected_reply_size * 8 + 28;
-        const int64_t rx_spi_bits =
-            (input.tx_can[i].expected_reply_size + 5) * 8;
-        const int64_t rx_ns =
-            1000000000 * rx_header_size_bits / arbitration_bitrate +
-            1000000000 * rx_data_size_bits / data_bitrate +
-            1000000000 * rx_spi_bits / config_.spi_speed_hz;
-
-        result.receive_ns[bus] += rx_ns;
-      }
+      result.send_ns[bus] += FrameSendNs(input.tx_can[i]);
+      result.receive_ns[bus] += FrameReceiveNs(input.tx_can[i]);
 
       if (input.tx_can[i].expect_reply) {
         result.count[bus]++;
@@ -1429,37 +1452,75 @@ class Pi3Hat::Impl {
     return result;
   }
 
-  void SendCan(const Input& input) {
-    // We try to send packets on alternating buses if possible, so we
-    // can reduce the average latency before the first data goes out
-    // on any bus.
+  // The SPI processor handling each bus: 0 and 1 on the aux SPI chip
+  // selects, 2 for the primary processor.
+  static int BusProcessor(int bus) {
+    switch (bus) {
+      case 1:
+      case 2: {
+        return 0;
+      }
+      case 3:
+      case 4: {
+        return 1;
+      }
+      case 5: {
+        return 2;
+      }
+    }
+    return -1;
+  }
+
+  void SendCan(const Input& input, const ExpectedReply& expected_replies) {
+    // The bus with the most wire time left decides when its last reply
+    // can arrive, so frames go out heaviest bus first.  Consecutive
+    // frames alternate between the processors where possible, so one
+    // can start transmitting while the next frame is written to
+    // another, and the first data goes out on every bus early.
     for (auto& bus_packets : can_packets_) {
       bus_packets.resize(0);
     }
 
+    int64_t remaining_ns[6] = {};
     for (size_t i = 0; i < input.tx_can.size(); i++) {
       const auto bus = input.tx_can[i].bus;
       can_packets_[bus].push_back(i);
+      remaining_ns[bus] =
+          expected_replies.send_ns[bus] + expected_replies.receive_ns[bus];
     }
 
     int bus_offset[6] = {};
+    int last_processor = -1;
     while (true) {
-      // We try to send out packets to buses in this order to minimize
-      // latency.
-      bool any_sent = false;
+      int best = 0;
+      bool best_alternates = false;
+      // Remaining ties go to the buses in this order.
       for (const int bus : { 1, 3, 5, 2, 4}) {
-        auto& offset = bus_offset[bus];
-        if (offset >= static_cast<int>(can_packets_[bus].size())) {
+        if (bus_offset[bus] >= static_cast<int>(can_packets_[bus].size())) {
           continue;
         }
-        const auto& can_packet = input.tx_can[can_packets_[bus][offset]];
-        offset++;
-
-        SendCanPacket(can_packet);
-        any_sent = true;
+        const bool alternates = BusProcessor(bus) != last_processor;
+        // An idle bus wins over one that already has a frame queued.
+        const bool better =
+            remaining_ns[bus] > remaining_ns[best] ||
+            (remaining_ns[bus] == remaining_ns[best] &&
+             bus_offset[bus] < bus_offset[best]);
+        if (best == 0 ||
+            (alternates && !best_alternates) ||
+            (alternates == best_alternates && better)) {
+          best = bus;
+          best_alternates = alternates;
+        }
       }
 
-      if (!any_sent) { break; }
+      if (best == 0) { break; }
+
+      const auto& can_packet = input.tx_can[can_packets_[best][bus_offset[best]]];
+      bus_offset[best]++;
+      remaining_ns[best] -= FrameSendNs(can_packet) + FrameReceiveNs(can_packet);
+      last_processor = BusProcessor(best);
+
+      SendCanPacket(can_packet);
     }
   }
 
@@ -1635,31 +1696,58 @@ class Pi3Hat::Impl {
     const auto start_now = GetNow();
     int64_t last_reply = start_now;
 
+    // No reply can end the cycle before this.
+    const int64_t deadline_ns = std::max<int64_t>(
+        std::max<int64_t>(input.timeout_ns, input.min_tx_wait_ns),
+        min_rx_timeout_ns);
+
+    if (config_.wait_strategy ==
+        Configuration::WaitStrategy::kSleepThenSpin &&
+        (bus_replies[0] || bus_replies[1] || bus_replies[2])) {
+      // Nothing can have come back yet, let another thread run.
+      SleepNs(std::min<int64_t>(config_.wait_sleep_first_ns, deadline_ns));
+    }
+
+    // Stamp the frames read since `first` with their bus latency.
+    auto note_latency = [&](size_t first) {
+      const auto latency = static_cast<uint32_t>(last_reply - start_now);
+      for (size_t i = first; i < output->rx_can_size; i++) {
+        const int bus = input.rx_can[i].bus;
+        if (bus > 0 && bus < 6) { output->rx_latency_ns[bus] = latency; }
+      }
+    };
+
     while (true) {
       bool any_found = false;
       // Then check for CAN responses as necessary.
       if (to_check[0]) {
+        const size_t first = output->rx_can_size;
         const int count = ReadCanFrames(aux_spi_, 0, 1, &input.rx_can, output);
         bus_replies[0] -= count;
         if (count) {
           last_reply = GetNow();
           any_found = true;
+          note_latency(first);
         }
       }
       if (to_check[1]) {
+        const size_t first = output->rx_can_size;
         const int count = ReadCanFrames(aux_spi_, 1, 3, &input.rx_can, output);
         bus_replies[1] -= count;
         if (count) {
           last_reply = GetNow();
           any_found = true;
+          note_latency(first);
         }
       }
       if (to_check[2] && config_.enable_aux) {
+        const size_t first = output->rx_can_size;
         const int count = ReadCanFrames(primary_spi_, 0, 5, &input.rx_can, output);
         bus_replies[2] -= count;
         if (count) {
           last_reply = GetNow();
           any_found = true;
+          note_latency(first);
         }
       }
 
@@ -1692,23 +1780,60 @@ class Pi3Hat::Impl {
       }
 
       if (!any_found) {
-        // Give the controllers a chance to rest.
-        BusyWaitUs(10);
+        WaitForReplies(delta_ns, deadline_ns);
       }
     }
   }
 
+  // Pause between two polls for CAN replies, `elapsed_ns` into the
+  // read phase.
+  void WaitForReplies(int64_t elapsed_ns, int64_t deadline_ns) {
+    using WS = Configuration::WaitStrategy;
+
+    int64_t spin_until_ns = 0;
+    switch (config_.wait_strategy) {
+      case WS::kSpin: {
+        spin_until_ns = deadline_ns;
+        break;
+      }
+      case WS::kSpinThenSleep: {
+        spin_until_ns = config_.wait_spin_ns;
+        break;
+      }
+      case WS::kSleepThenSpin: {
+        spin_until_ns =
+            static_cast<int64_t>(config_.wait_sleep_first_ns) +
+            config_.wait_spin_ns;
+        break;
+      }
+    }
+
+    const int64_t remaining_ns = deadline_ns - elapsed_ns;
+    if (elapsed_ns < spin_until_ns ||
+        remaining_ns <= static_cast<int64_t>(config_.wait_poll_sleep_ns)) {
+      // Give the controllers a chance to rest.
+      BusyWaitUs(10);
+      return;
+    }
+
+    SleepNs(config_.wait_poll_sleep_ns);
+  }
+
   Output Cycle(const Input& input) {
     Output result;
 
     auto expected_replies = CalculateExpectedReply(input);
 
+    const auto start_ns = GetNow();
+
     // First, ensure there aren't any receive frames sitting around
     // before we start for CAN busses we expect to have a reply for.
     FlushReadCan(input, expected_replies, &result);
+    const auto flush_done_ns = GetNow();
 
     // Send off all our CAN data to all buses.
-    SendCan(input);
+    SendCan(input, expected_replies);
+    const auto send_done_ns = GetNow();
 
     // While those are sending, do our other work.
     if (input.tx_rf.size()) {
@@ -1724,8 +1849,27 @@ class Pi3Hat::Impl {
           GetAttitude(input.attitude, input.wait_for_attitude,
                       input.request_attitude_detail);
     }
+    const auto other_done_ns = GetNow();
 
     ReadCan(input, expected_replies, &result);
+    const auto read_done_ns = GetNow();
+
+    result.flush_ns = static_cast<uint32_t>(flush_done_ns - start_ns);
+    result.send_ns = static_cast<uint32_t>(send_done_ns - flush_done_ns);
+    result.rf_attitude_ns = static_cast<uint32_t>(other_done_ns - send_done_ns);
+    result.read_ns = static_cast<uint32_t>(read_done_ns - other_done_ns);
+    for (int bus = 1; bus < 6; bus++) {
+      result.can_wire_ns[bus] = static_cast<uint32_t>(
+          expected_replies.send_ns[bus] + expected_replies.receive_ns[bus]);
+    }
+    for (size_t i = 0; i < input.tx_can.size(); i++) {
+      const int bus = input.tx_can[i].bus;
+      if (bus > 0 && bus < 6) { result.tx_frames[bus]++; }
+    }
+    for (size_t i = 0; i < result.rx_can_size; i++) {
+      const int bus = input.rx_can[i].bus;
+      if (bus > 0 && bus < 6) { result.rx_frames[bus]++; }
+    }
 
     primary_spi_.gpio()->SetGpioMode(13, Rpi3Gpio::OUTPUT);
     static bool debug_toggle = false;
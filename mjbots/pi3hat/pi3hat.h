@@ -183,6 +183,27 @@ class Pi3Hat {
     // If true, nothing is guaranteed to work but ReadSpi.
     bool raw_spi_only = false;
 
+    /// How Cycle waits for CAN replies between polls of the CAN
+    /// processors.
+    ///  * kSpin - busy wait the whole reply window (lowest latency,
+    ///    one core at 100%)
+    ///  * kSpinThenSleep - busy wait for wait_spin_ns after the read
+    ///    phase starts, then sleep wait_poll_sleep_ns between polls
+    ///  * kSleepThenSpin - sleep wait_sleep_first_ns (the expected
+    ///    reply latency), busy wait for wait_spin_ns, then sleep
+    ///    between polls as above
+    ///
+    /// Sleeps never run past the reply deadline of the cycle.
+    enum class WaitStrategy {
+      kSpin,
+      kSpinThenSleep,
+      kSleepThenSpin,
+    };
+    WaitStrategy wait_strategy = WaitStrategy::kSpin;
+    uint32_t wait_spin_ns = 300000;
+    uint32_t wait_sleep_first_ns = 200000;
+    uint32_t wait_poll_sleep_ns = 50000;
+
     Configuration() {}
   };
 
@@ -261,6 +282,25 @@ class Pi3Hat {
 
     // This will only be updated if 'Input::request_rf' is true
     uint32_t rf_lock_age_ms = 0;
+
+    // Time from the start of the read phase until the last reply on
+    // each bus was read, or 0 if there was none.  1 indexed to match
+    // the bus naming.
+    uint32_t rx_latency_ns[6] = {};
+
+    // Time spent in each phase of the cycle.
+    uint32_t flush_ns = 0;
+    uint32_t send_ns = 0;
+    uint32_t rf_attitude_ns = 0;
+    uint32_t read_ns = 0;
+
+    // CAN frames sent and received on each bus, 1 indexed.
+    uint16_t tx_frames[6] = {};
+    uint16_t rx_frames[6] = {};
+
+    // Estimated wire time of each bus this cycle, the frames sent plus
+    // the replies expected, 1 indexed.
+    uint32_t can_wire_ns[6] = {};
   };
 
   /// Do some or all of the following:
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <map>
@@ -54,6 +55,74 @@ class Pi3HatMoteusTransport : public moteus::Transport {
     // This can be used to configure timeouts.  Any pointers used to
     // accept results will be ignored.
     pi3hat::Pi3Hat::Input default_input;
+
+  };
+
+  /// Durations in log2 buckets: bucket i counts [2^i, 2^(i+1)) us,
+  /// bucket 0 also holds anything below 1us.
+  struct DurationHistogram {
+    static constexpr int kBuckets = 16;
+
+    uint32_t buckets[kBuckets] = {};
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint32_t max_ns = 0;
+
+    void Add(uint32_t ns) {
+      uint32_t us = ns / 1000;
+      int bucket = 0;
+      while (us > 1 && bucket < kBuckets - 1) {
+        us >>= 1;
+        bucket++;
+      }
+      buckets[bucket]++;
+      count++;
+      total_ns += ns;
+      max_ns = std::max(max_ns, ns);
+    }
+
+    /// Upper edge in us of the bucket holding the given percentile.
+    uint32_t PercentileUs(double percentile) const {
+      if (count == 0) { return 0; }
+      const double wanted = percentile / 100.0 * count;
+      uint64_t seen = 0;
+      for (int i = 0; i < kBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= wanted) { return 2u << i; }
+      }
+      return 2u << (kBuckets - 1);
+    }
+
+    uint32_t MeanUs() const {
+      return count ? static_cast<uint32_t>(total_ns / count / 1000) : 0;
+    }
+  };
+
+  struct Statistics {
+    // Phases of Pi3Hat::Cycle and the whole call
+    DurationHistogram flush;
+    DurationHistogram send;
+    DurationHistogram rf_attitude;
+    DurationHistogram read;
+    DurationHistogram total;
+
+    // CAN frames per bus, 1 indexed
+    uint64_t tx_frames[6] = {};
+    uint64_t rx_frames[6] = {};
+
+    // Estimated wire time per bus (Pi3Hat::Output::can_wire_ns), summed
+    // over the cycles in `total` and the largest single cycle
+    uint64_t can_wire_ns[6] = {};
+    uint32_t can_wire_max_ns[6] = {};
+
+    uint32_t CanWireMeanUs(int bus) const {
+      return total.count ?
+          static_cast<uint32_t>(can_wire_ns[bus] / total.count / 1000) : 0;
+    }
+
+    // Latest processor counters, see request_device_performance()
+    pi3hat::Pi3Hat::DevicePerformance device_performance;
+    bool device_performance_valid = false;
   };
 
   Pi3HatMoteusTransport(const Options& options)
@@ -93,6 +162,48 @@ class Pi3HatMoteusTransport : public moteus::Transport {
     condition_.notify_one();
   }
 
+  /// Counters collected since the last reset.  Safe to call from any
+  /// thread.
+  Statistics statistics(bool reset = false) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    Statistics result = stats_;
+    if (reset) {
+      stats_ = Statistics();
+      stats_.device_performance = result.device_performance;
+      stats_.device_performance_valid = result.device_performance_valid;
+    }
+    return result;
+  }
+
+  /// Query the firmware and protocol information of all processors.
+  /// This runs on the pi3hat thread and blocks until it completes, so
+  /// it must not be called from a completion callback.
+  pi3hat::Pi3Hat::DeviceInfo device_info() {
+    pi3hat::Pi3Hat::DeviceInfo result;
+    moteus::BlockingCallback cbk;
+    auto done = cbk.callback();
+    Post([&]() {
+      result = pi3hat_->device_info();
+      done(0);
+    });
+    cbk.Wait();
+    return result;
+  }
+
+  /// Read the processor performance counters into statistics() on the
+  /// pi3hat thread, without waiting for it.  The read is its own SPI
+  /// transaction (a few hundred us), posted to run between cycles: call
+  /// it right after a cycle completes, so a Cycle() issued while the
+  /// read is still running is the only one that can be delayed.
+  void request_device_performance() {
+    Post([this]() {
+      const auto performance = pi3hat_->device_performance();
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.device_performance = performance;
+      stats_.device_performance_valid = true;
+    });
+  }
+
   void Cycle(const CanFdFrame* frames,
              size_t size,
              std::vector<CanFdFrame>* replies,
@@ -192,7 +303,26 @@ class Pi3HatMoteusTransport : public moteus::Transport {
     input.attitude = cycle_data_.attitude;
     if (input.attitude) { input.request_attitude = true; }
 
+    const auto start = std::chrono::steady_clock::now();
     const auto output = pi3hat_->Cycle(input);
+    const auto total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.flush.Add(output.flush_ns);
+      stats_.send.Add(output.send_ns);
+      stats_.rf_attitude.Add(output.rf_attitude_ns);
+      stats_.read.Add(output.read_ns);
+      stats_.total.Add(static_cast<uint32_t>(total_ns));
+      for (int bus = 1; bus < 6; bus++) {
+        stats_.tx_frames[bus] += output.tx_frames[bus];
+        stats_.rx_frames[bus] += output.rx_frames[bus];
+        stats_.can_wire_ns[bus] += output.can_wire_ns[bus];
+        stats_.can_wire_max_ns[bus] =
+            std::max(stats_.can_wire_max_ns[bus], output.can_wire_ns[bus]);
+      }
+    }
 
     if (cycle_data_.pi3hat_output) { *cycle_data_.pi3hat_output = output; }
     if (cycle_data_.replies) {
@@ -246,6 +376,10 @@ class Pi3HatMoteusTransport : public moteus::Transport {
   CycleData cycle_data_;
   std::deque<std::function<void()>> event_queue_;
 
+  // Guards stats_ only, so statistics() never waits on a cycle.
+  std::mutex stats_mutex_;
+  Statistics stats_;
+
   std::thread thread_;
 
   ////////////////////////////////////////////////////////////////////
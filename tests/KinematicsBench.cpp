@@ -0,0 +1,108 @@
+// Benchmark for batched wheel kinematics:
+//   - Generates N random candidate body twists (structure of arrays)
+//   - Times Wheel_math::calculate() one twist at a time, the scalar batch
+//     and the SIMD batch over the same candidates
+//   - Checks that the SIMD batch matches the scalar reference
+//
+// Usage: ./Kinematics_bench [--n 512] [--iters 2000]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "wheel_math.h"
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double timeUs(int iters, F &&body)
+{
+    const auto start = Clock::now();
+    for (int i = 0; i < iters; ++i) body();
+    const auto end = Clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iters;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = 512;
+    int iters = 2000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--n" && i + 1 < argc) n = std::stoul(argv[++i]);
+        else if (a == "--iters" && i + 1 < argc) iters = std::stoi(argv[++i]);
+        else if (a == "-h" || a == "--help") {
+            std::cerr << "Usage: " << argv[0] << " [--n N] [--iters N]\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown arg: " << a << "\n";
+            return 1;
+        }
+    }
+
+    Wheel_math m;
+    m.setMode(2); // unsafe: calculate() evaluates every twist without printing
+    std::cout << "\n";
+
+    // ----- Candidate twists, some deliberately out of limits -----
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> lin(-2.5f, 2.5f);
+    std::uniform_real_distribution<float> ang(-4.0f, 4.0f);
+    std::vector<float> vx(n), vy(n), vw(n);
+    for (size_t k = 0; k < n; ++k) {
+        vx[k] = lin(rng);
+        vy[k] = lin(rng);
+        vw[k] = ang(rng);
+    }
+
+    std::vector<float> simd_out[4], scalar_out[4];
+    for (int i = 0; i < 4; ++i) {
+        simd_out[i].resize(n);
+        scalar_out[i].resize(n);
+    }
+    float *const simd_ptr[4] = {simd_out[0].data(), simd_out[1].data(),
+                                simd_out[2].data(), simd_out[3].data()};
+    float *const scalar_ptr[4] = {scalar_out[0].data(), scalar_out[1].data(),
+                                  scalar_out[2].data(), scalar_out[3].data()};
+    std::vector<uint8_t> simd_ok(n), scalar_ok(n);
+
+    // ----- Timing -----
+    volatile double sink = 0.0;
+    const int single_iters = std::max(1, iters / 10);
+    const double single_us = timeUs(single_iters, [&]() {
+        for (size_t k = 0; k < n; ++k) {
+            sink = sink + m.calculate(vx[k], vy[k], vw[k])[0];
+        }
+    });
+    const double scalar_us = timeUs(iters, [&]() {
+        m.calculate_batch_scalar(vx.data(), vy.data(), vw.data(), n, scalar_ptr, scalar_ok.data());
+    });
+    const double simd_us = timeUs(iters, [&]() {
+        m.calculate_batch(vx.data(), vy.data(), vw.data(), n, simd_ptr, simd_ok.data());
+    });
+
+    // ----- Check SIMD against the scalar reference -----
+    float max_err = 0.f;
+    size_t mask_mismatch = 0, feasible = 0;
+    for (size_t k = 0; k < n; ++k) {
+        for (int i = 0; i < 4; ++i)
+            max_err = std::max(max_err, std::abs(simd_out[i][k] - scalar_out[i][k]));
+        mask_mismatch += simd_ok[k] != scalar_ok[k];
+        feasible += simd_ok[k];
+    }
+
+    std::cout << "Candidates: " << n << "  (" << feasible << " feasible)\n"
+              << "calculate() x N : " << single_us << " us\n"
+              << "batch scalar    : " << scalar_us << " us\n"
+              << "batch SIMD      : " << simd_us << " us\n"
+              << "max |SIMD - scalar| = " << max_err
+              << ", mask mismatches = " << mask_mismatch << "\n";
+
+    return (mask_mismatch == 0 && max_err < 1e-3f) ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Benchmark for the full Telemetry::cycle() path on the configured
+// transport (Motor.yaml transport.type):
+//   - Runs N back to back cycles commanding every motor
+//   - Reports cycle time mean, p50, p99 and max, and the reply rate
+//
+// Without motors, set transport.type to socketcan with iface vcan0 and
+// run ./Vcan_responder next to it, or use simulated.
+//
+// Usage: ./Telemetry_bench [--cycles 5000] [--velocity 1.0]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Telemetry.h"
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char **argv)
+{
+    int cycles = 5000;
+    double velocity = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--cycles" && i + 1 < argc) cycles = std::stoi(argv[++i]);
+        else if (a == "--velocity" && i + 1 < argc) velocity = std::stod(argv[++i]);
+        else if (a == "-h" || a == "--help") {
+            std::cerr << "Usage: " << argv[0] << " [--cycles N] [--velocity rev/s]\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown arg: " << a << "\n";
+            return 1;
+        }
+    }
+    cycles = std::max(cycles, 1);
+
+    Telemetry telemetry;
+    std::cout << "Transport: " << telemetry.transportType()
+              << ", motors: " << telemetry.controllers.size() << "\n";
+
+    std::map<int, double> velocity_map, zero_map;
+    for (const auto &pair : telemetry.controllers) {
+        velocity_map[pair.first] = velocity;
+        zero_map[pair.first] = 0.0;
+    }
+
+    // ----- Timing -----
+    std::vector<double> cycle_us(cycles);
+    uint64_t replies = 0;
+    for (int i = 0; i < cycles; ++i) {
+        const auto start = Clock::now();
+        const auto data = telemetry.cycle(velocity_map);
+        cycle_us[i] = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        replies += data.size();
+    }
+    telemetry.cycle(zero_map);
+    for (const auto &pair : telemetry.controllers) pair.second->SetStop();
+
+    double total_us = 0.0;
+    for (double us : cycle_us) total_us += us;
+    std::sort(cycle_us.begin(), cycle_us.end());
+    auto percentile = [&](double p) {
+        return cycle_us[std::min(cycle_us.size() - 1, static_cast<size_t>(p / 100.0 * cycle_us.size()))];
+    };
+
+    const uint64_t expected = static_cast<uint64_t>(cycles) * telemetry.controllers.size();
+    std::cout << "Cycles: " << cycles << "\n"
+              << "mean : " << total_us / cycles << " us\n"
+              << "p50  : " << percentile(50.0) << " us\n"
+              << "p99  : " << percentile(99.0) << " us\n"
+              << "max  : " << cycle_us.back() << " us\n"
+              << "replies " << replies << " / " << expected << "\n";
+
+    return replies == expected ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Software moteus controllers on a Linux CAN interface, for running
+// Telemetry with transport.type socketcan on a box without motors:
+//   - Answers every motor in Motor.yaml motorMap with MoteusEmulator
+//   - Advances the wheel model in real time
+//   - Ctrl+C exits
+//
+// Set up a virtual CAN-FD interface first:
+//   sudo ip link add dev vcan0 type vcan
+//   sudo ip link set vcan0 mtu 72
+//   sudo ip link set up vcan0
+//
+// Usage: ./Vcan_responder [--iface vcan0] [--reply-delay-us 0]
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Telemetry.h"
+#include "SimulatedTransport.h"
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> stop_flag{false};
+
+void signalHandler(int /*signum*/) {
+    stop_flag.store(true, std::memory_order_relaxed);
+}
+
+static int openCan(const std::string &iface)
+{
+    const int fd = ::socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) return -1;
+
+    struct ifreq ifr = {};
+    std::strncpy(ifr.ifr_name, iface.c_str(), sizeof(ifr.ifr_name) - 1);
+    const int enable_canfd = 1;
+    struct sockaddr_can addr = {};
+    if (::ioctl(fd, SIOCGIFINDEX, &ifr) < 0 ||
+        ::setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable_canfd, sizeof(enable_canfd)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv)
+{
+    std::string iface = "vcan0";
+    int reply_delay_us = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--iface" && i + 1 < argc) iface = argv[++i];
+        else if (a == "--reply-delay-us" && i + 1 < argc) reply_delay_us = std::stoi(argv[++i]);
+        else if (a == "-h" || a == "--help") {
+            std::cerr << "Usage: " << argv[0] << " [--iface vcan0] [--reply-delay-us N]\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown arg: " << a << "\n";
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, signalHandler);
+
+    const int fd = openCan(iface);
+    if (fd < 0) {
+        std::cerr << "Could not open CAN-FD interface " << iface << ": "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // Same motors as the robot, the model advances 1 ms per step
+    const std::map<int, int> motor_map =
+        Telemetry::YAML_Load_MotorMap("../config/Motor.yaml");
+    MoteusEmulator::Options options;
+    options.step_s = 0.001;
+    MoteusEmulator emulator(options);
+    for (const auto &p : motor_map) emulator.addServo(p.first, p.second);
+
+    std::cout << "Answering " << motor_map.size() << " motors on " << iface << "\n";
+
+    auto next_step = Clock::now();
+    uint64_t frames = 0, replies = 0;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        const auto now = Clock::now();
+        while (next_step <= now) {
+            emulator.step();
+            next_step += std::chrono::milliseconds(1);
+        }
+
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, 1) <= 0) continue;
+
+        struct canfd_frame in = {};
+        if (::read(fd, &in, sizeof(in)) <= 0) continue;
+        frames++;
+
+        mjbots::moteus::CanFdFrame command;
+        command.arbitration_id = in.can_id & CAN_EFF_MASK;
+        command.size = in.len;
+        std::memcpy(command.data, in.data, in.len);
+
+        mjbots::moteus::CanFdFrame reply;
+        if (!emulator.handle(command, &reply)) continue;
+
+        if (reply_delay_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(reply_delay_us));
+        }
+
+        struct canfd_frame out = {};
+        out.can_id = reply.arbitration_id;
+        if (out.can_id > CAN_SFF_MASK) out.can_id |= CAN_EFF_FLAG;
+        out.len = mjbots::moteus::details::TimeoutTransport::RoundUpDlc(reply.size);
+        std::memcpy(out.data, reply.data, reply.size);
+        std::memset(&out.data[reply.size], 0x50, out.len - reply.size);
+        out.flags = CANFD_BRS;
+        if (::write(fd, &out, sizeof(out)) > 0) replies++;
+    }
+
+    std::cout << "\nFrames: " << frames << ", replies: " << replies << "\n";
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,222 @@
+// Offline benchmark and accuracy check for BallDetection::process():
+//   - Replays a video file or an image directory (Vision.yaml settings)
+//   - Reports per-frame latency mean, p50, p90, p99, max and fps
+//   - With a labels file, also the detection rate, false positives and
+//     centroid error against the labelled ball positions
+//
+// Frames are loaded up front so disk and decode time are not measured.
+// Every --repeat pass runs a new detector over the same frames.
+//
+// Labels are CSV, one line per labelled frame, '#' starts a comment:
+//   frame,found,px,py
+// where frame is the 0-based frame index, or the image file name for a
+// directory, and found is 0 or 1 (px, py only needed when found).
+// Unlabelled frames count for timing only.
+//
+// Usage: ./Vision_bench --input <video|dir> [--labels file.csv]
+//                       [--match-px 15] [--repeat 1] [--max-frames 0]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "detect_ball.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Label {
+    bool  found;
+    float px, py;
+};
+
+std::string base_name(const std::string &path)
+{
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool load_labels(const std::string &file, std::map<std::string, Label> &labels)
+{
+    std::ifstream in(file);
+    if (!in) {
+        std::cerr << "Cannot open labels " << file << "\n";
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(field);
+
+        Label label{false, 0.f, 0.f};
+        std::string key;
+        try {
+            if (fields.size() < 2) throw std::invalid_argument("too few fields");
+            const size_t first = fields[0].find_first_not_of(" \t");
+            if (first == std::string::npos) throw std::invalid_argument("empty frame field");
+            const size_t last = fields[0].find_last_not_of(" \t");
+            key = fields[0].substr(first, last - first + 1);
+            label.found = std::stoi(fields[1]) != 0;
+            if (label.found) {
+                if (fields.size() < 4) throw std::invalid_argument("found without px, py");
+                label.px = std::stof(fields[2]);
+                label.py = std::stof(fields[3]);
+            }
+        } catch (const std::exception &e) {
+            std::cerr << file << ":" << line_no << ": " << e.what() << "\n";
+            return false;
+        }
+        labels[key] = label;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    std::string input, labels_file;
+    float match_px = 15.f;
+    int repeat = 1;
+    int max_frames = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--input" && i + 1 < argc) input = argv[++i];
+        else if (a == "--labels" && i + 1 < argc) labels_file = argv[++i];
+        else if (a == "--match-px" && i + 1 < argc) match_px = std::stof(argv[++i]);
+        else if (a == "--repeat" && i + 1 < argc) repeat = std::stoi(argv[++i]);
+        else if (a == "--max-frames" && i + 1 < argc) max_frames = std::stoi(argv[++i]);
+        else if (a == "-h" || a == "--help") {
+            std::cerr << "Usage: " << argv[0] << " --input <video|dir> [--labels file.csv]"
+                      << " [--match-px px] [--repeat N] [--max-frames N]\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown arg: " << a << "\n";
+            return 1;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "--input is required\n";
+        return 1;
+    }
+    repeat = std::max(repeat, 1);
+
+    std::map<std::string, Label> labels;
+    if (!labels_file.empty() && !load_labels(labels_file, labels)) return 1;
+
+    std::unique_ptr<FrameSource> source = FrameSource::open(input, 30);
+    if (!source || source->live()) {
+        std::cerr << "Cannot replay " << input << "\n";
+        return 1;
+    }
+    const ImageDirSource *dir = dynamic_cast<const ImageDirSource *>(source.get());
+
+    // ----- Load -----
+    std::vector<CameraFrame> frames;
+    std::vector<const Label *> frame_labels;
+    CameraFrame frame;
+    while ((max_frames <= 0 || static_cast<int>(frames.size()) < max_frames) && source->read(frame)) {
+        const std::string key = dir ? base_name(dir->files()[frame.sequence])
+                                    : std::to_string(frame.sequence);
+        const auto it = labels.find(key);
+        frame_labels.push_back(it == labels.end() ? nullptr : &it->second);
+        frames.push_back(CameraFrame{frame.image.clone(), frame.stamp_ns, frame.sequence});
+    }
+    if (frames.empty()) {
+        std::cerr << "No frames in " << input << "\n";
+        return 1;
+    }
+    std::cout << "Frames: " << frames.size() << " (" << frames.front().image.cols << "x"
+              << frames.front().image.rows << "), labelled: "
+              << std::count_if(frame_labels.begin(), frame_labels.end(),
+                               [](const Label *l) { return l != nullptr; }) << "\n";
+
+    // ----- Run -----
+    std::vector<double> frame_us;
+    frame_us.reserve(frames.size() * repeat);
+    int detections = 0, positives = 0, true_positives = 0, negatives = 0, false_positives = 0;
+    std::vector<double> error_px;
+
+    for (int r = 0; r < repeat; ++r) {
+        // Fresh per pass, so every pass starts without a track like the
+        // one the accuracy figures come from
+        BallDetection detector;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const auto start = Clock::now();
+            const BallObservation obs = detector.process(frames[i].image);
+            frame_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+            // Accuracy from the first pass only
+            if (r > 0) continue;
+            if (obs.found) detections++;
+            const Label *label = frame_labels[i];
+            if (!label) continue;
+            if (label->found) {
+                positives++;
+                if (!obs.found) continue;
+                const double err = std::hypot(obs.px - label->px, obs.py - label->py);
+                if (err <= match_px) {
+                    true_positives++;
+                    error_px.push_back(err);
+                } else {
+                    // Found something, but not the ball
+                    false_positives++;
+                }
+            } else {
+                negatives++;
+                if (obs.found) false_positives++;
+            }
+        }
+    }
+
+    // ----- Report -----
+    double total_us = 0.0;
+    for (double us : frame_us) total_us += us;
+    std::sort(frame_us.begin(), frame_us.end());
+    auto percentile = [](const std::vector<double> &v, double p) {
+        return v[std::min(v.size() - 1, static_cast<size_t>(p / 100.0 * v.size()))];
+    };
+
+    std::cout << "Latency over " << frame_us.size() << " frames\n"
+              << "mean : " << total_us / frame_us.size() << " us\n"
+              << "p50  : " << percentile(frame_us, 50.0) << " us\n"
+              << "p90  : " << percentile(frame_us, 90.0) << " us\n"
+              << "p99  : " << percentile(frame_us, 99.0) << " us\n"
+              << "max  : " << frame_us.back() << " us\n"
+              << "fps  : " << frame_us.size() / (total_us * 1e-6) << "\n"
+              << "detections: " << detections << " / " << frames.size() << "\n";
+
+    if (positives + negatives > 0) {
+        std::cout << "detection rate : " << true_positives << " / " << positives;
+        if (positives > 0) std::cout << " (" << 100.0 * true_positives / positives << " %)";
+        std::cout << "\nfalse positives: " << false_positives
+                  << " (" << negatives << " labelled without ball)\n";
+        if (!error_px.empty()) {
+            double sum = 0.0;
+            for (double e : error_px) sum += e;
+            std::sort(error_px.begin(), error_px.end());
+            std::cout << "centroid error : mean " << sum / error_px.size()
+                      << " px, p50 " << percentile(error_px, 50.0)
+                      << " px, p95 " << percentile(error_px, 95.0)
+                      << " px, max " << error_px.back() << " px\n";
+        }
+    }
+
+    return 0;
+}